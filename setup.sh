@@ -1,6 +1,6 @@
 ## remove original program
 exe="dmsg"
-srcList="src/main.cpp src/text.cpp src/dmsg.cpp src/bitseq.cpp"
+srcList="src/main.cpp src/text.cpp src/dmsg.cpp src/bitseq.cpp src/bitops.cpp src/classify.cpp src/kmat.cpp"
 if [ -f $exe ]
 then
 	echo "delete original exe..." 
@@ -9,7 +9,7 @@ fi
 
 # comple
 echo "compile to generate dmsg..."
-clang++ -std=c++0x $srcList -o $exe
+clang++ -std=c++0x -O2 -pthread $srcList -o $exe
 if [ ! -f $exe ]
 then
 	echo "compilation error! Now exit..."
@@ -0,0 +1,441 @@
+#include "bitops.h"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DMSG_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+// memory
+word * alloc_words(size_t n) {
+	if (n == 0) return nullptr;
+	void * mem = nullptr;
+#if defined(_MSC_VER)
+	mem = _aligned_malloc(n * sizeof(word), VECTOR_BYTES);
+#else
+	if (posix_memalign(&mem, VECTOR_BYTES, n * sizeof(word)) != 0)
+		mem = nullptr;
+#endif
+	if (mem == nullptr) throw std::bad_alloc();
+	return (word *)mem;
+}
+word * alloc_huge_words(size_t n) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	/* blocks of huge pages (2 MB) are aligned to them and advised to be backed by them */
+	const size_t HUGE_PAGE = 2 << 20;
+	if (n * sizeof(word) >= HUGE_PAGE) {
+		void * mem = nullptr;
+		size_t bytes = (n * sizeof(word) + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+		if (posix_memalign(&mem, HUGE_PAGE, bytes) != 0) throw std::bad_alloc();
+		madvise(mem, bytes, MADV_HUGEPAGE);
+		return (word *)mem;
+	}
+#endif
+	return alloc_words(n);
+}
+void free_words(word * words) {
+#if defined(_MSC_VER)
+	_aligned_free(words);
+#else
+	free(words);
+#endif
+}
+
+// arena
+WordArena::WordArena(size_t n) 
+	: blocks(), block_words(n), left(0), cursor(nullptr), footprint_bytes(0) {}
+WordArena::~WordArena() { clear(); }
+word * WordArena::allocate(size_t n) {
+	if (n > left) {
+		/* objects larger than a block get a block of their own */
+		size_t size = (n > block_words) ? n : block_words;
+		size = (size + VECTOR_WORDS - 1) / VECTOR_WORDS * VECTOR_WORDS;
+		word * block = alloc_words(size);
+		blocks.push_back(block);
+		footprint_bytes += size * sizeof(word);
+		if (size > block_words) return block;
+		cursor = block; left = size;
+	}
+	word * ans = cursor;
+	cursor += n; left -= n;
+	return ans;
+}
+void WordArena::clear() {
+	for (size_t i = 0; i < blocks.size(); i++)
+		free_words(blocks[i]);
+	blocks.clear();
+	left = 0; cursor = nullptr; footprint_bytes = 0;
+}
+
+// scalar kernels (portable)
+static bool scalar_subsume(const word * x, const word * y, size_t n) {
+	for (size_t i = 0; i < n; i++)
+		if ((x[i] & ~y[i]) != 0) return false;
+	return true;
+}
+static void scalar_conjunct(word * x, const word * y, size_t n) {
+	for (size_t i = 0; i < n; i++) x[i] &= y[i];
+}
+static void scalar_disjunct(word * x, const word * y, size_t n) {
+	for (size_t i = 0; i < n; i++) x[i] |= y[i];
+}
+static void scalar_differ(word * x, const word * y, size_t n) {
+	for (size_t i = 0; i < n; i++) x[i] ^= y[i];
+}
+static void scalar_exclude(word * x, const word * y, size_t n) {
+	for (size_t i = 0; i < n; i++) x[i] &= ~y[i];
+}
+static bool scalar_intersects(const word * x, const word * y, size_t n) {
+	for (size_t i = 0; i < n; i++)
+		if ((x[i] & y[i]) != 0) return true;
+	return false;
+}
+static bool scalar_any(const word * x, size_t n) {
+	for (size_t i = 0; i < n; i++)
+		if (x[i] != 0) return true;
+	return false;
+}
+static bool scalar_equals(const word * x, const word * y, size_t n) {
+	for (size_t i = 0; i < n; i++)
+		if (x[i] != y[i]) return false;
+	return true;
+}
+static size_t scalar_popcount(const word * x, size_t n) {
+	size_t count = 0;
+	for (size_t i = 0; i < n; i++) count += word_popcount(x[i]);
+	return count;
+}
+/* clear the words of result for count rows */
+static inline void clear_rows_result(word * result, size_t count) {
+	memset(result, 0, sizeof(word) * ((count + WORD_BITS - 1) / WORD_BITS));
+}
+static void scalar_subsume_rows(const word * x, const word * rows, size_t stride, size_t n, size_t count, word * result) {
+	clear_rows_result(result, count);
+	for (size_t r = 0; r < count; r++, rows += stride) {
+		word d = 0;
+		for (size_t i = 0; i < n; i++) d |= x[i] & ~rows[i];
+		if (d == 0) result[r / WORD_BITS] |= 1ULL << (r % WORD_BITS);
+	}
+}
+static const BitKernels SCALAR_KERNELS = {
+	"scalar", scalar_subsume, scalar_conjunct, scalar_disjunct, scalar_differ,
+	scalar_exclude, scalar_intersects, scalar_any, scalar_equals, scalar_popcount,
+	scalar_subsume_rows
+};
+
+#ifdef DMSG_X86_KERNELS
+// popcnt instruction (used by SSE2 kernels and as fallback of AVX kernels)
+__attribute__((target("popcnt")))
+static size_t popcnt_popcount(const word * x, size_t n) {
+	size_t count = 0;
+	for (size_t i = 0; i < n; i++)
+		count += (size_t)__builtin_popcountll(x[i]);
+	return count;
+}
+
+// SSE2 kernels: 2 words per step
+__attribute__((target("sse2")))
+static bool sse2_subsume(const word * x, const word * y, size_t n) {
+	const __m128i zero = _mm_setzero_si128();
+	for (size_t i = 0; i < n; i += 2) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(x + i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(y + i));
+		__m128i d = _mm_andnot_si128(b, a);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(d, zero)) != 0xFFFF) return false;
+	}
+	return true;
+}
+__attribute__((target("sse2")))
+static void sse2_conjunct(word * x, const word * y, size_t n) {
+	for (size_t i = 0; i < n; i += 2) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(x + i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(y + i));
+		_mm_storeu_si128((__m128i *)(x + i), _mm_and_si128(a, b));
+	}
+}
+/* x = op(x, y) for an SSE2 intrinsic op */
+#define SSE2_BINARY(name, expr) \
+__attribute__((target("sse2"))) \
+static void name(word * x, const word * y, size_t n) { \
+	for (size_t i = 0; i < n; i += 2) { \
+		__m128i a = _mm_loadu_si128((const __m128i *)(x + i)); \
+		__m128i b = _mm_loadu_si128((const __m128i *)(y + i)); \
+		_mm_storeu_si128((__m128i *)(x + i), expr); \
+	} \
+}
+SSE2_BINARY(sse2_disjunct, _mm_or_si128(a, b))
+SSE2_BINARY(sse2_differ, _mm_xor_si128(a, b))
+SSE2_BINARY(sse2_exclude, _mm_andnot_si128(b, a))
+__attribute__((target("sse2")))
+static bool sse2_intersects(const word * x, const word * y, size_t n) {
+	const __m128i zero = _mm_setzero_si128();
+	for (size_t i = 0; i < n; i += 2) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(x + i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(y + i));
+		__m128i d = _mm_and_si128(a, b);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(d, zero)) != 0xFFFF) return true;
+	}
+	return false;
+}
+__attribute__((target("sse2")))
+static bool sse2_any(const word * x, size_t n) {
+	const __m128i zero = _mm_setzero_si128();
+	for (size_t i = 0; i < n; i += 2) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(x + i));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, zero)) != 0xFFFF) return true;
+	}
+	return false;
+}
+__attribute__((target("sse2")))
+static bool sse2_equals(const word * x, const word * y, size_t n) {
+	for (size_t i = 0; i < n; i += 2) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(x + i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(y + i));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xFFFF) return false;
+	}
+	return true;
+}
+__attribute__((target("sse2")))
+static void sse2_subsume_rows(const word * x, const word * rows, size_t stride, size_t n, size_t count, word * result) {
+	const __m128i zero = _mm_setzero_si128();
+	clear_rows_result(result, count);
+	for (size_t r = 0; r < count; r++, rows += stride) {
+		__m128i d = zero;
+		for (size_t i = 0; i < n; i += 2) {
+			__m128i a = _mm_loadu_si128((const __m128i *)(x + i));
+			__m128i b = _mm_loadu_si128((const __m128i *)(rows + i));
+			d = _mm_or_si128(d, _mm_andnot_si128(b, a));
+		}
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(d, zero)) == 0xFFFF)
+			result[r / WORD_BITS] |= 1ULL << (r % WORD_BITS);
+	}
+}
+
+// AVX2 kernels: 4 words per step
+__attribute__((target("avx2")))
+static bool avx2_subsume(const word * x, const word * y, size_t n) {
+	for (size_t i = 0; i < n; i += 4) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)(x + i));
+		__m256i b = _mm256_loadu_si256((const __m256i *)(y + i));
+		/* testc(b, a) is 1 iff (~b & a) == 0 */
+		if (!_mm256_testc_si256(b, a)) return false;
+	}
+	return true;
+}
+__attribute__((target("avx2")))
+static void avx2_conjunct(word * x, const word * y, size_t n) {
+	for (size_t i = 0; i < n; i += 4) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)(x + i));
+		__m256i b = _mm256_loadu_si256((const __m256i *)(y + i));
+		_mm256_storeu_si256((__m256i *)(x + i), _mm256_and_si256(a, b));
+	}
+}
+/* x = op(x, y) for an AVX2 intrinsic op */
+#define AVX2_BINARY(name, expr) \
+__attribute__((target("avx2"))) \
+static void name(word * x, const word * y, size_t n) { \
+	for (size_t i = 0; i < n; i += 4) { \
+		__m256i a = _mm256_loadu_si256((const __m256i *)(x + i)); \
+		__m256i b = _mm256_loadu_si256((const __m256i *)(y + i)); \
+		_mm256_storeu_si256((__m256i *)(x + i), expr); \
+	} \
+}
+AVX2_BINARY(avx2_disjunct, _mm256_or_si256(a, b))
+AVX2_BINARY(avx2_differ, _mm256_xor_si256(a, b))
+AVX2_BINARY(avx2_exclude, _mm256_andnot_si256(b, a))
+__attribute__((target("avx2")))
+static bool avx2_intersects(const word * x, const word * y, size_t n) {
+	for (size_t i = 0; i < n; i += 4) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)(x + i));
+		__m256i b = _mm256_loadu_si256((const __m256i *)(y + i));
+		if (!_mm256_testz_si256(a, b)) return true;
+	}
+	return false;
+}
+__attribute__((target("avx2")))
+static bool avx2_any(const word * x, size_t n) {
+	for (size_t i = 0; i < n; i += 4) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)(x + i));
+		if (!_mm256_testz_si256(a, a)) return true;
+	}
+	return false;
+}
+__attribute__((target("avx2")))
+static bool avx2_equals(const word * x, const word * y, size_t n) {
+	for (size_t i = 0; i < n; i += 4) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)(x + i));
+		__m256i b = _mm256_loadu_si256((const __m256i *)(y + i));
+		__m256i d = _mm256_xor_si256(a, b);
+		if (!_mm256_testz_si256(d, d)) return false;
+	}
+	return true;
+}
+/* nibble-table popcount (Mula) summed by sad over bytes */
+__attribute__((target("avx2")))
+static size_t avx2_popcount(const word * x, size_t n) {
+	const __m256i table = _mm256_setr_epi8(
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i low_mask = _mm256_set1_epi8(0x0F);
+	__m256i total = _mm256_setzero_si256();
+	for (size_t i = 0; i < n; i += 4) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(x + i));
+		__m256i lo = _mm256_and_si256(v, low_mask);
+		__m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+		__m256i cnt = _mm256_add_epi8(
+			_mm256_shuffle_epi8(table, lo), _mm256_shuffle_epi8(table, hi));
+		total = _mm256_add_epi64(total, _mm256_sad_epu8(cnt, _mm256_setzero_si256()));
+	}
+	return (size_t)(_mm256_extract_epi64(total, 0) + _mm256_extract_epi64(total, 1)
+		+ _mm256_extract_epi64(total, 2) + _mm256_extract_epi64(total, 3));
+}
+__attribute__((target("avx2")))
+static void avx2_subsume_rows(const word * x, const word * rows, size_t stride, size_t n, size_t count, word * result) {
+	clear_rows_result(result, count);
+	for (size_t r = 0; r < count; r++, rows += stride) {
+		__m256i d = _mm256_setzero_si256();
+		for (size_t i = 0; i < n; i += 4) {
+			__m256i a = _mm256_loadu_si256((const __m256i *)(x + i));
+			__m256i b = _mm256_loadu_si256((const __m256i *)(rows + i));
+			d = _mm256_or_si256(d, _mm256_andnot_si256(b, a));
+		}
+		if (_mm256_testz_si256(d, d))
+			result[r / WORD_BITS] |= 1ULL << (r % WORD_BITS);
+	}
+}
+
+// AVX-512 kernels: 8 words per step
+__attribute__((target("avx512f")))
+static bool avx512_subsume(const word * x, const word * y, size_t n) {
+	for (size_t i = 0; i < n; i += 8) {
+		__m512i a = _mm512_loadu_si512((const void *)(x + i));
+		__m512i b = _mm512_loadu_si512((const void *)(y + i));
+		if (_mm512_cmpneq_epi64_mask(_mm512_and_si512(a, b), a) != 0) return false;
+	}
+	return true;
+}
+__attribute__((target("avx512f")))
+static void avx512_conjunct(word * x, const word * y, size_t n) {
+	for (size_t i = 0; i < n; i += 8) {
+		__m512i a = _mm512_loadu_si512((const void *)(x + i));
+		__m512i b = _mm512_loadu_si512((const void *)(y + i));
+		_mm512_storeu_si512((void *)(x + i), _mm512_and_si512(a, b));
+	}
+}
+/* x = op(x, y) for an AVX-512 intrinsic op */
+#define AVX512_BINARY(name, expr) \
+__attribute__((target("avx512f"))) \
+static void name(word * x, const word * y, size_t n) { \
+	for (size_t i = 0; i < n; i += 8) { \
+		__m512i a = _mm512_loadu_si512((const void *)(x + i)); \
+		__m512i b = _mm512_loadu_si512((const void *)(y + i)); \
+		_mm512_storeu_si512((void *)(x + i), expr); \
+	} \
+}
+AVX512_BINARY(avx512_disjunct, _mm512_or_si512(a, b))
+AVX512_BINARY(avx512_differ, _mm512_xor_si512(a, b))
+AVX512_BINARY(avx512_exclude, _mm512_ternarylogic_epi64(a, b, b, 0x30))
+__attribute__((target("avx512f")))
+static bool avx512_intersects(const word * x, const word * y, size_t n) {
+	for (size_t i = 0; i < n; i += 8) {
+		__m512i a = _mm512_loadu_si512((const void *)(x + i));
+		__m512i b = _mm512_loadu_si512((const void *)(y + i));
+		if (_mm512_test_epi64_mask(a, b) != 0) return true;
+	}
+	return false;
+}
+__attribute__((target("avx512f")))
+static bool avx512_any(const word * x, size_t n) {
+	for (size_t i = 0; i < n; i += 8) {
+		__m512i a = _mm512_loadu_si512((const void *)(x + i));
+		if (_mm512_test_epi64_mask(a, a) != 0) return true;
+	}
+	return false;
+}
+__attribute__((target("avx512f")))
+static bool avx512_equals(const word * x, const word * y, size_t n) {
+	for (size_t i = 0; i < n; i += 8) {
+		__m512i a = _mm512_loadu_si512((const void *)(x + i));
+		__m512i b = _mm512_loadu_si512((const void *)(y + i));
+		if (_mm512_cmpneq_epi64_mask(a, b) != 0) return false;
+	}
+	return true;
+}
+__attribute__((target("avx512f,avx512vpopcntdq")))
+static size_t avx512_popcount(const word * x, size_t n) {
+	__m512i total = _mm512_setzero_si512();
+	for (size_t i = 0; i < n; i += 8) {
+		__m512i v = _mm512_loadu_si512((const void *)(x + i));
+		total = _mm512_add_epi64(total, _mm512_popcnt_epi64(v));
+	}
+	alignas(VECTOR_BYTES) long long lanes[8];
+	_mm512_store_si512((void *)lanes, total);
+	long long sum = 0;
+	for (int k = 0; k < 8; k++) sum += lanes[k];
+	return (size_t)sum;
+}
+__attribute__((target("avx512f")))
+static void avx512_subsume_rows(const word * x, const word * rows, size_t stride, size_t n, size_t count, word * result) {
+	clear_rows_result(result, count);
+	for (size_t r = 0; r < count; r++, rows += stride) {
+		__mmask8 d = 0;
+		for (size_t i = 0; i < n; i += 8) {
+			__m512i a = _mm512_loadu_si512((const void *)(x + i));
+			__m512i b = _mm512_loadu_si512((const void *)(rows + i));
+			d |= _mm512_cmpneq_epi64_mask(_mm512_and_si512(a, b), a);
+		}
+		if (d == 0)
+			result[r / WORD_BITS] |= 1ULL << (r % WORD_BITS);
+	}
+}
+
+static BitKernels SSE2_KERNELS = {
+	"sse2", sse2_subsume, sse2_conjunct, sse2_disjunct, sse2_differ,
+	sse2_exclude, sse2_intersects, sse2_any, sse2_equals, scalar_popcount,
+	sse2_subsume_rows
+};
+static BitKernels AVX2_KERNELS = {
+	"avx2", avx2_subsume, avx2_conjunct, avx2_disjunct, avx2_differ,
+	avx2_exclude, avx2_intersects, avx2_any, avx2_equals, avx2_popcount,
+	avx2_subsume_rows
+};
+static BitKernels AVX512_KERNELS = {
+	"avx512", avx512_subsume, avx512_conjunct, avx512_disjunct, avx512_differ,
+	avx512_exclude, avx512_intersects, avx512_any, avx512_equals, avx2_popcount,
+	avx512_subsume_rows
+};
+#endif
+
+/* select the widest kernels supported by CPU, unless forced by DMSG_SIMD */
+static const BitKernels * select_kernels() {
+	const char * forced = getenv("DMSG_SIMD");
+	if (forced != nullptr && strcmp(forced, "scalar") == 0)
+		return &SCALAR_KERNELS;
+#ifdef DMSG_X86_KERNELS
+	__builtin_cpu_init();
+	bool popcnt = __builtin_cpu_supports("popcnt");
+	bool sse2 = __builtin_cpu_supports("sse2");
+	bool avx2 = __builtin_cpu_supports("avx2");
+	bool avx512 = __builtin_cpu_supports("avx512f");
+	if (forced != nullptr) {
+		if (strcmp(forced, "sse2") == 0) avx2 = avx512 = false;
+		else if (strcmp(forced, "avx2") == 0) avx512 = false;
+	}
+
+	if (popcnt) SSE2_KERNELS.popcount = popcnt_popcount;
+	if (avx512 && avx2) {
+		if (__builtin_cpu_supports("avx512vpopcntdq"))
+			AVX512_KERNELS.popcount = avx512_popcount;
+		return &AVX512_KERNELS;
+	}
+	else if (avx2) return &AVX2_KERNELS;
+	else if (sse2) return &SSE2_KERNELS;
+#endif
+	return &SCALAR_KERNELS;
+}
+const BitKernels * bit_kernels = select_kernels();
@@ -0,0 +1,143 @@
+#pragma once
+
+/*
+	File: bitops.h
+	-Aim: to define word-level kernels over bit sequences (selected by CPU at runtime)
+	-Dat: Oct 16th, 2026
+	-Art: Lin Huan
+	-Cls:
+		[0] word;
+		[1] struct BitKernels;
+		[2] alloc_words, alloc_huge_words, free_words;
+		[3] word_ctz, word_clz, word_popcount;
+		[4] fixed_subsume<W>, fixed_equals<W>;
+		[5] class WordArena;
+*/
+
+#include <cstddef>
+#include <vector>
+
+/* a word of 64 bits, the storage unit of bit sequences */
+typedef unsigned long long word;
+
+/* number of bits in a word */
+static const unsigned int WORD_BITS = 64;
+/* number of bytes in the widest vector register (AVX-512) */
+static const unsigned int VECTOR_BYTES = 64;
+/* number of words in the widest vector register, to which sequences are padded */
+static const unsigned int VECTOR_WORDS = VECTOR_BYTES / sizeof(word);
+
+/*
+*	Kernels over word arrays. The length (in words) of every array passed in
+*	must be a multiple of VECTOR_WORDS; arrays aligned to VECTOR_BYTES are faster.
+* */
+struct BitKernels {
+	/* name of the instruction set used by kernels */
+	const char * name;
+	/* whether (x & ~y) is zero for n words */
+	bool (*subsume)(const word * x, const word * y, size_t n);
+	/* x = x & y for n words */
+	void (*conjunct)(word * x, const word * y, size_t n);
+	/* x = x | y for n words */
+	void (*disjunct)(word * x, const word * y, size_t n);
+	/* x = x ^ y for n words */
+	void (*differ)(word * x, const word * y, size_t n);
+	/* x = x & ~y for n words */
+	void (*exclude)(word * x, const word * y, size_t n);
+	/* whether (x & y) is not zero for n words (stop at the first common bit) */
+	bool (*intersects)(const word * x, const word * y, size_t n);
+	/* whether there is any bit-1 in n words */
+	bool (*any)(const word * x, size_t n);
+	/* whether x == y for n words */
+	bool (*equals)(const word * x, const word * y, size_t n);
+	/* number of bit-1 in n words */
+	size_t (*popcount)(const word * x, size_t n);
+	/* one against many: bit r of result is whether (x & ~row) is zero for n words of the rth row, 
+	for count rows of stride words (result has count / 64 words rounded up) */
+	void (*subsume_rows)(const word * x, const word * rows, size_t stride, size_t n, size_t count, word * result);
+};
+
+/* kernels selected for the running CPU (DMSG_SIMD=scalar|sse2|avx2|avx512 forces a set) */
+extern const BitKernels * bit_kernels;
+
+/* index of the lowest bit-1 in a non-zero word */
+inline unsigned int word_ctz(word w) {
+#if defined(__GNUC__)
+	return (unsigned int)__builtin_ctzll(w);
+#else
+	unsigned int k = 0;
+	while ((w & 1ULL) == 0) { w >>= 1; k++; }
+	return k;
+#endif
+}
+/* number of bit-0 above the highest bit-1 in a non-zero word */
+inline unsigned int word_clz(word w) {
+#if defined(__GNUC__)
+	return (unsigned int)__builtin_clzll(w);
+#else
+	unsigned int k = 0;
+	while ((w & 0x8000000000000000ULL) == 0) { w <<= 1; k++; }
+	return k;
+#endif
+}
+/* number of bit-1 in a word */
+inline unsigned int word_popcount(word w) {
+#if defined(__GNUC__)
+	return (unsigned int)__builtin_popcountll(w);
+#else
+	w = w - ((w >> 1) & 0x5555555555555555ULL);
+	w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+	w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (unsigned int)((w * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/* whether (x & ~y) is zero for W words, fully unrolled for a compile-time width */
+template<unsigned int W> inline bool fixed_subsume(const word * x, const word * y) {
+	word d = 0;
+	for (unsigned int i = 0; i < W; i++) d |= x[i] & ~y[i];
+	return d == 0;
+}
+/* whether x == y for W words, fully unrolled for a compile-time width */
+template<unsigned int W> inline bool fixed_equals(const word * x, const word * y) {
+	word d = 0;
+	for (unsigned int i = 0; i < W; i++) d |= x[i] ^ y[i];
+	return d == 0;
+}
+
+/* allocate n words aligned to VECTOR_BYTES (n must be multiple of VECTOR_WORDS) */
+word * alloc_words(size_t n);
+/* allocate n words for a large block, on huge pages when the system supports them (aligned to VECTOR_BYTES at least) */
+word * alloc_huge_words(size_t n);
+/* release words allocated by alloc_words or alloc_huge_words */
+void free_words(word *);
+
+/* arena of aligned blocks where small objects are allocated and released all at once */
+class WordArena {
+public:
+	/* create an empty arena allocating blocks of specified words */
+	WordArena(size_t block_words = 8192);
+	/* release all blocks */
+	~WordArena();
+
+	/* allocate n words (not initialized) */
+	word * allocate(size_t n);
+	/* allocate memory for an object of specified bytes (aligned to word) */
+	void * allocate_bytes(size_t bytes) { return allocate((bytes + sizeof(word) - 1) / sizeof(word)); }
+	/* number of bytes in blocks allocated by arena */
+	size_t footprint() const { return footprint_bytes; }
+	/* release all blocks */
+	void clear();
+
+private:
+	/* blocks allocated by alloc_words */
+	std::vector<word *> blocks;
+	/* number of words in each (common) block */
+	size_t block_words;
+	/* number of words left in the last block */
+	size_t left;
+	/* next free word in the last block */
+	word * cursor;
+	/* number of bytes in blocks */
+	size_t footprint_bytes;
+};
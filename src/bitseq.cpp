@@ -1,112 +1,485 @@
 #include "bitseq.h"
 #include <queue>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+#include <new>
 #include "text.h"
 #include <iostream>
 
 // BitSeq 
-BitSeq::BitSeq(const BitSeq & seq) : bit_num(seq.bit_num), length(seq.length) {
-	bytes = nullptr;
-	if (seq.length > 0) {
-		bytes = new byte[seq.length];
-		for (int i = 0; i < seq.length; i++) {
-			bytes[i] = seq.bytes[i];
+/* number of words (padded to vector width) to maintain specified bits */
+static inline BitSeq::size_t words_of_bits(BitSeq::size_t bitnum) {
+	BitSeq::size_t n = (bitnum + WORD_BITS - 1) / WORD_BITS;
+	return (n + VECTOR_WORDS - 1) / VECTOR_WORDS * VECTOR_WORDS;
+}
+/* index of the first item in [lo, n) not less than key, galloping from lo */
+static inline size_t gallop(const unsigned int * a, size_t lo, size_t n, unsigned int key) {
+	size_t hi = lo, step = 1;
+	while (hi < n && a[hi] < key) {
+		lo = hi + 1; hi += step; step <<= 1;
+	}
+	if (hi > n) hi = n;
+	return std::lower_bound(a + lo, a + hi, key) - a;
+}
+/* whether the ith bit in words is 1 */
+static inline bool test_word_bit(const word * words, BitSeq::size_t i) {
+	return ((words[i / WORD_BITS] >> (i % WORD_BITS)) & 1ULL) != 0;
+}
+/* mix a non-zero word at index k into hash h */
+static inline word hash_mix(word h, word k, word w) {
+	h ^= w + 0x9E3779B97F4A7C15ULL + (k << 6) + (k >> 2);
+	h *= 0xFF51AFD7ED558CCDULL;
+	return h ^ (h >> 32);
+}
+void BitSeq::allocate() {
+	if (length <= VECTOR_WORDS) words = local;
+	else words = alloc_words(length);
+}
+void BitSeq::release() {
+	if (words != local && !borrowed) free_words(words);
+	words = local; borrowed = false;
+}
+void BitSeq::to_sparse() {
+	if (sparse) return;
+	release(); length = 0;
+	new (&items) std::vector<unsigned int>();
+	sparse = true;
+}
+void BitSeq::to_dense() {
+	if (!sparse) return;
+	items.~vector();
+	sparse = false; length = 0;
+}
+BitSeq::BitSeq(const BitSeq & seq) 
+	: bit_num(seq.bit_num), length(seq.length), sparse(seq.sparse), borrowed(false) {
+	allocate();
+	if (sparse) new (&items) std::vector<unsigned int>(seq.items);
+	else if (length > 0) 
+		memcpy(words, seq.words, sizeof(word) * length);
+}
+BitSeq::BitSeq(BitSeq && seq) noexcept 
+	: bit_num(seq.bit_num), length(seq.length), sparse(seq.sparse), borrowed(seq.borrowed) {
+	if (sparse) {
+		words = local;
+		new (&items) std::vector<unsigned int>(std::move(seq.items));
+		seq.bit_num = 0;
+	}
+	else if (seq.words != seq.local) {
+		words = seq.words;
+		seq.words = seq.local; seq.borrowed = false;
+		seq.bit_num = seq.length = 0;
+	}
+	else {
+		words = local;
+		memcpy(words, seq.words, sizeof(word) * length);
+	}
+}
+BitSeq::BitSeq(BitSeq::size_t bitnum) : bit_num(bitnum), sparse(false), borrowed(false) {
+	length = words_of_bits(bitnum);
+	allocate();
+	if (length > 0) 
+		memset(words, 0, sizeof(word) * length);
+}
+BitSeq::~BitSeq() { release(); to_dense(); }
+BitSeq & BitSeq::operator = (const BitSeq & seq) {
+	if (this == &seq) return *this;
+	else if (seq.sparse) {
+		to_sparse(); items = seq.items;
+	}
+	else {
+		to_dense();
+		if (length != seq.length) {
+			release();
+			length = seq.length;
+			allocate();
+		}
+		if (length > 0)
+			memcpy(words, seq.words, sizeof(word) * length);
+	}
+	bit_num = seq.bit_num;
+	return *this;
+}
+BitSeq & BitSeq::operator = (BitSeq && seq) noexcept {
+	if (this == &seq) return *this;
+	else if (seq.sparse) {
+		to_sparse(); items = std::move(seq.items);
+		bit_num = seq.bit_num;
+	}
+	else if (seq.words != seq.local) {
+		to_dense(); release();
+		bit_num = seq.bit_num; length = seq.length;
+		words = seq.words; borrowed = seq.borrowed;
+		seq.words = seq.local; seq.borrowed = false;
+		seq.bit_num = seq.length = 0;
+	}
+	else {
+		to_dense();
+		if (length != seq.length) {
+			release();
+			length = seq.length;
 		}
+		bit_num = seq.bit_num;
+		memcpy(words, seq.words, sizeof(word) * length);
+	}
+	return *this;
+}
+void BitSeq::borrow(word * source) {
+	if (sparse) throw "Invalid access: sparse sequence";
+	if (length > 0) memcpy(source, words, sizeof(word) * length);
+	release();
+	words = source; borrowed = true;
+}
+void BitSeq::unborrow() {
+	if (!borrowed) return;
+	word * source = words;
+	borrowed = false; allocate();
+	memcpy(words, source, sizeof(word) * length);
+}
+void BitSeq::compact() {
+	if (sparse || bit_num <= INLINE_BITS) return;
+	/* an index takes 32 bits, keep words unless indexes take half of them */
+	size_t n = count();
+	if ((unsigned long long)n * 64 > bit_num) return;
+
+	std::vector<unsigned int> positions; positions.reserve(n);
+	for (size_t i = first_bit(); i < bit_num; i = next_bit(i))
+		positions.push_back(i);
+	/* items take the place of words */
+	to_sparse(); items.swap(positions);
+}
+void BitSeq::expand() {
+	if (!sparse) return;
+	std::vector<unsigned int> positions; positions.swap(items);
+	to_dense();
+	length = words_of_bits(bit_num);
+	allocate();
+	memset(words, 0, sizeof(word) * length);
+	for (size_t k = 0; k < positions.size(); k++)
+		words[positions[k] / WORD_BITS] |= 1ULL << (positions[k] % WORD_BITS);
+}
+void BitSeq::set_positions(const unsigned int * positions, size_t n) {
+	to_sparse();
+	items.assign(positions, positions + n);
+	for (size_t k = 0; k < n; k++) {
+		if (items[k] >= bit_num || (k > 0 && items[k] <= items[k - 1]))
+			throw "Invalid positions at: ", k;
 	}
 }
-BitSeq::BitSeq(BitSeq::size_t bitnum) : bit_num(bitnum) {
-	length = bitnum / 8;
-	if (bitnum % 8 != 0) length++;
+void BitSeq::set_words(const word * source, size_t n) {
+	if (sparse) { items.clear(); expand(); }
+	size_t limit = (bit_num + WORD_BITS - 1) / WORD_BITS;
+	if (n > limit) throw "Invalid words: ", n, " ( limits = ", limit, " )";
 
-	bytes = nullptr;
-	if (length > 0) {
-		bytes = new byte[length];
-		for (int i = 0; i < length; i++) {
-			bytes[i] = 0;
+	if (n > 0) memcpy(words, source, sizeof(word) * n);
+	memset(words + n, 0, sizeof(word) * (length - n));
+	/* bits out of the sequence are kept zero */
+	if (n > 0 && n * WORD_BITS > bit_num) 
+		words[n - 1] &= ~0ULL >> (n * WORD_BITS - bit_num);
+}
+word BitSeq::hash() const {
+	word h = 0xCBF29CE484222325ULL ^ bit_num;
+	if (!sparse) {
+		size_t n = (bit_num + WORD_BITS - 1) / WORD_BITS;
+		for (size_t k = 0; k < n; k++)
+			if (words[k] != 0) h = hash_mix(h, k, words[k]);
+	}
+	else {
+		/* rebuild each non-zero word from indexes */
+		size_t k = 0, n = items.size();
+		while (k < n) {
+			word wk = items[k] / WORD_BITS, wd = 0;
+			while (k < n && items[k] / WORD_BITS == wk)
+				wd |= 1ULL << (items[k++] % WORD_BITS);
+			h = hash_mix(h, wk, wd);
 		}
 	}
+	return h;
 }
-BitSeq::~BitSeq() {
-	if (bytes != nullptr)
-		delete bytes;
+word BitSeq::fold() const {
+	word f = 0;
+	if (!sparse) {
+		size_t n = (bit_num + WORD_BITS - 1) / WORD_BITS;
+		for (size_t k = 0; k < n; k++) f |= words[k];
+	}
+	else {
+		auto beg = items.begin(), end = items.end();
+		while (beg != end) f |= 1ULL << (*(beg++) % WORD_BITS);
+	}
+	return f;
 }
 BitSeq::size_t BitSeq::bit_number() const { return bit_num; }
+bool BitSeq::has(BitSeq::size_t index) const {
+	if (index >= bit_num) return false;
+	else if (sparse) return std::binary_search(items.begin(), items.end(), index);
+	else return test_word_bit(words, index);
+}
 bit BitSeq::get_bit(BitSeq::size_t index) const {
 	if (index >= bit_num)
 		throw "Invalid index: ", index, " ( limits = ", bit_num, " )";
-	else {
-		byte bk = bytes[index / 8];
-		return (bk & BIT_LOC[index % 8]) != 0;
-	}
+	else if (sparse)
+		return std::binary_search(items.begin(), items.end(), index);
+	else 
+		return test_word_bit(words, index);
 }
 void BitSeq::set_bit(BitSeq::size_t index, bit val) {
 	if (index >= bit_num)
 		throw "Invalid index: ", index, " ( limits = ", bit_num, " )";
+	else if (sparse) {
+		auto iter = std::lower_bound(items.begin(), items.end(), index);
+		bool found = (iter != items.end() && *iter == index);
+		if (val && !found) items.insert(iter, index);
+		else if (!val && found) items.erase(iter);
+	}
 	else {
-		byte bk = bytes[index / 8];
-		bit oval = ((bk & BIT_LOC[index % 8]) != 0);
-		if (oval != val) 
-			bytes[index / 8] = bytes[index / 8] ^ BIT_LOC[index % 8]; 
+		word mask = 1ULL << (index % WORD_BITS);
+		if (val) words[index / WORD_BITS] |= mask;
+		else words[index / WORD_BITS] &= ~mask;
 	}
 }
+void BitSeq::trim() {
+	if (bit_num % WORD_BITS != 0)
+		words[bit_num / WORD_BITS] &= (1ULL << (bit_num % WORD_BITS)) - 1;
+}
 void BitSeq::conjunct(const BitSeq & seq) {
-	int bits = (bit_num < seq.bit_num) ? bit_num : seq.bit_num;
-	for (int i = 0; i < bits; i++)
-		this->set_bit(i, seq.get_bit(i));
+	if (sparse) {
+		/* keep indexes that are 1 in seq */
+		size_t n = 0;
+		for (size_t k = 0; k < items.size(); k++)
+			if (seq.has(items[k])) items[n++] = items[k];
+		items.resize(n);
+	}
+	else if (seq.sparse) {
+		/* only bits at seq's indexes can survive */
+		std::vector<unsigned int> kept;
+		for (size_t k = 0; k < seq.items.size(); k++)
+			if (has(seq.items[k])) kept.push_back(seq.items[k]);
+		memset(words, 0, sizeof(word) * length);
+		for (size_t k = 0; k < kept.size(); k++)
+			words[kept[k] / WORD_BITS] |= 1ULL << (kept[k] % WORD_BITS);
+	}
+	else {
+		size_t n = (length < seq.length) ? length : seq.length;
+		bit_kernels->conjunct(words, seq.words, n);
+		if (n < length)
+			memset(words + n, 0, sizeof(word) * (length - n));
+	}
 }
-std::string BitSeq::to_string() const {
-	std::string str;
-	for (int i = 0; i < length; i++) {
-		for (int j = 0; j < 8 && i * 8 + j < bit_num; j++) {
-			if ((bytes[i] & BIT_LOC[j]) != 0)
-				str += '1';
-			else str += '0';
+void BitSeq::disjunct(const BitSeq & seq) {
+	if (sparse && seq.sparse) {
+		std::vector<unsigned int> merged;
+		std::set_union(items.begin(), items.end(), seq.items.begin(),
+			std::lower_bound(seq.items.begin(), seq.items.end(), bit_num), 
+			std::back_inserter(merged));
+		items.swap(merged);
+		return;
+	}
+	else if (sparse) expand();
+
+	if (seq.sparse) {
+		for (size_t k = 0; k < seq.items.size() && seq.items[k] < bit_num; k++)
+			words[seq.items[k] / WORD_BITS] |= 1ULL << (seq.items[k] % WORD_BITS);
+	}
+	else {
+		size_t n = (length < seq.length) ? length : seq.length;
+		bit_kernels->disjunct(words, seq.words, n);
+		if (seq.bit_num > bit_num) trim();
+	}
+}
+void BitSeq::differ(const BitSeq & seq) {
+	if (sparse && seq.sparse) {
+		std::vector<unsigned int> merged;
+		std::set_symmetric_difference(items.begin(), items.end(), seq.items.begin(),
+			std::lower_bound(seq.items.begin(), seq.items.end(), bit_num), 
+			std::back_inserter(merged));
+		items.swap(merged);
+		return;
+	}
+	else if (sparse) expand();
+
+	if (seq.sparse) {
+		for (size_t k = 0; k < seq.items.size() && seq.items[k] < bit_num; k++)
+			words[seq.items[k] / WORD_BITS] ^= 1ULL << (seq.items[k] % WORD_BITS);
+	}
+	else {
+		size_t n = (length < seq.length) ? length : seq.length;
+		bit_kernels->differ(words, seq.words, n);
+		if (seq.bit_num > bit_num) trim();
+	}
+}
+void BitSeq::exclude(const BitSeq & seq) {
+	if (sparse) {
+		size_t n = 0;
+		for (size_t k = 0; k < items.size(); k++)
+			if (!seq.has(items[k])) items[n++] = items[k];
+		items.resize(n);
+	}
+	else if (seq.sparse) {
+		for (size_t k = 0; k < seq.items.size() && seq.items[k] < bit_num; k++)
+			words[seq.items[k] / WORD_BITS] &= ~(1ULL << (seq.items[k] % WORD_BITS));
+	}
+	else {
+		size_t n = (length < seq.length) ? length : seq.length;
+		bit_kernels->exclude(words, seq.words, n);
+	}
+}
+bool BitSeq::intersects(const BitSeq & seq) const {
+	if (sparse && seq.sparse) {
+		const unsigned int * a = items.data(), * b = seq.items.data();
+		size_t i = 0, j = 0, n = items.size(), m = seq.items.size();
+		while (i < n && j < m) {
+			if (a[i] == b[j]) return true;
+			else if (a[i] < b[j]) i = gallop(a, i, n, b[j]);
+			else j = gallop(b, j, m, a[i]);
 		}
+		return false;
+	}
+	else if (sparse || seq.sparse) {
+		const BitSeq & s = sparse ? *this : seq;
+		const BitSeq & d = sparse ? seq : *this;
+		for (size_t k = 0; k < s.items.size(); k++)
+			if (d.has(s.items[k])) return true;
+		return false;
+	}
+	else {
+		size_t n = (length < seq.length) ? length : seq.length;
+		return bit_kernels->intersects(words, seq.words, n);
+	}
+}
+bool BitSeq::any() const { 
+	if (sparse) return !items.empty();
+	else return bit_kernels->any(words, length); 
+}
+BitSeq::size_t BitSeq::scan_from(size_t k, word wd) const {
+	size_t n = (bit_num + WORD_BITS - 1) / WORD_BITS;
+	while (wd == 0) {
+		if (++k >= n) return bit_num;
+		wd = words[k];
 	}
+	return k * WORD_BITS + word_ctz(wd);
+}
+BitSeq::size_t BitSeq::first_bit() const {
+	if (sparse) return items.empty() ? bit_num : items[0];
+	else if (bit_num == 0) return bit_num;
+	else return scan_from(0, words[0]);
+}
+BitSeq::size_t BitSeq::next_bit(size_t index) const {
+	if (sparse) {
+		auto iter = std::upper_bound(items.begin(), items.end(), index);
+		return iter == items.end() ? bit_num : *iter;
+	}
+	else if (++index >= bit_num) return bit_num;
+	else {
+		size_t k = index / WORD_BITS;
+		return scan_from(k, words[k] & (~0ULL << (index % WORD_BITS)));
+	}
+}
+BitSeq operator & (const BitSeq & x, const BitSeq & y) {
+	BitSeq seq(x); seq.conjunct(y); return seq;
+}
+BitSeq operator | (const BitSeq & x, const BitSeq & y) {
+	BitSeq seq(x); seq.disjunct(y); return seq;
+}
+BitSeq operator ^ (const BitSeq & x, const BitSeq & y) {
+	BitSeq seq(x); seq.differ(y); return seq;
+}
+BitSeq operator - (const BitSeq & x, const BitSeq & y) {
+	BitSeq seq(x); seq.exclude(y); return seq;
+}
+BitSeq::size_t BitSeq::count() const {
+	if (sparse) return items.size();
+	else return (size_t)bit_kernels->popcount(words, length);
+}
+std::string BitSeq::to_string() const {
+	std::string str(bit_num, '0');
+	for (size_t i = first_bit(); i < bit_num; i = next_bit(i))
+		str[i] = '1';
 	return str;
 }
 BitSeq BitSeq::subseq(BitSeq::size_t start, BitSeq::size_t end) const {
 	if(start > bit_num)
 		throw "Invalid index: ", start, " ( limits = ", bit_num, " )";
 	else if(end > bit_num)
-		"Invalid index: ", end, " ( limits = ", bit_num, " )";
+		throw "Invalid index: ", end, " ( limits = ", bit_num, " )";
 	else if(start > end)
-		"Invalid index: ", start, "; ", end;
+		throw "Invalid index: ", start, "; ", end;
+	else if (sparse) {
+		BitSeq seq(end - start);
+		auto beg = std::lower_bound(items.begin(), items.end(), start);
+		while (beg != items.end() && *beg < end)
+			seq.set_bit(*(beg++) - start, BIT_1);
+		return seq;
+	}
 	else {
-		BitSeq seq(end - start); int k = 0;
-		while (start < end) {
-			bit obit = this->get_bit(start++);
-			seq.set_bit(k++, obit);
+		/* shift words of [start, end) down to the 0th bit */
+		BitSeq seq(end - start);
+		size_t r = start % WORD_BITS, k = start / WORD_BITS;
+		size_t n = (end - start + WORD_BITS - 1) / WORD_BITS;
+		size_t used = (bit_num + WORD_BITS - 1) / WORD_BITS;
+		for (size_t j = 0; j < n; j++, k++) {
+			word wd = words[k] >> r;
+			if (r != 0 && k + 1 < used) 
+				wd |= words[k + 1] << (WORD_BITS - r);
+			seq.words[j] = wd;
 		}
+		seq.trim();
 		return seq;
 	}
 }
-bool BitSeq::subsume(const BitSeq & y) const {
-	int n = (length < y.length) ? length : y.length;
-	for (int i = 0; i < n; i++) {
-		byte b1 = bytes[i];
-		byte b2 = y.bytes[i];
-		if (b1 != (b1 & b2)) return false;
+bool BitSeq::subsume_words(const BitSeq & y) const {
+	if (!sparse && !y.sparse) {
+		size_t n = (length < y.length) ? length : y.length;
+		return bit_kernels->subsume(words, y.words, n);
+	}
+	else if (sparse && !y.sparse) {
+		for (size_t k = 0; k < items.size(); k++)
+			if (!y.has(items[k])) return false;
+		return true;
+	}
+	else {
+		/* y is sparse: every bit-1 in this must be found in y's indexes */
+		const unsigned int * b = y.items.data();
+		size_t j = 0, m = y.items.size();
+		if (count() > m) return false;
+		for (size_t i = first_bit(); i < bit_num; i = next_bit(i)) {
+			j = gallop(b, j, m, i);
+			if (j >= m || b[j] != i) return false;
+		}
+		return true;
 	}
-	return true;
 }
-int BitSeq::byte_number() const { return length; }
-byte * BitSeq::get_bytes() const { return bytes; }
+bool BitSeq::equals_words(const BitSeq & y) const {
+	if (!sparse && !y.sparse) 
+		return bit_kernels->equals(words, y.words, length);
+	else if (sparse && y.sparse) 
+		return items == y.items;
+	else return count() == y.count() && subsume_words(y);
+}
+int BitSeq::byte_number() const { return sparse ? 0 : (bit_num + 7) / 8; }
+byte * BitSeq::get_bytes() const { 
+	if (sparse) throw "Invalid access: bytes of sparse sequence";
+	else return (byte *)words; 
+}
 void BitSeq::set_bytes(const byte * new_bytes, size_t size) {
-	size_t n = (length < size) ? length : size;
-	for (int i = 0; i < n; i++) 
-		bytes[i] = new_bytes[i];
+	expand();
+	size_t n = (byte_number() < size) ? byte_number() : size;
+	memcpy(words, new_bytes, n);
+	/* keep the padding bits as zero */
+	trim();
 }
 
 // KillVector
-KillVector::KillVector(long id, BitSeq::size_t testnum, const std::list<BitSeq::size_t> & killset) : mid(id), vector(testnum) {
+KillVector::KillVector(long id, BitSeq::size_t testnum, const std::vector<BitSeq::size_t> & killset) : mid(id), vector(testnum) {
 	auto beg = killset.begin();
 	auto end = killset.end();
 	while (beg != end) {
 		BitSeq::size_t test_id = *(beg++);
 		vector.set_bit(test_id, BIT_1);
-		quantity++;
 	}
+	/* duplicated tests in kill-set are counted once */
+	quantity = vector.count();
 }
+KillVector::KillVector(BitSeq::size_t testnum) : mid(-1), quantity(0), vector(testnum) {}
 KillVector::~KillVector() {}
 long KillVector::get_mutant_ID() const { return mid; }
 int KillVector::get_quantity() const { return quantity; }
@@ -116,66 +489,92 @@ unsigned int KillVector::get_test_number() const { return vector.bit_number(); }
 // KillVectorProducer
 // KillVectorProducer::KillVectorProducer(BitSeq::size_t test_num) : testnum(test_num), bias(0) {}
 KillVectorProducer::KillVectorProducer(BitSeq::size_t test_num, BitSeq::size_t _bias) : testnum(test_num), bias(_bias) {}
-std::string KillVectorProducer::nextToken(const std::string & line, int & index) const {
-	std::string token; int n = line.length(); char ch;
+static inline bool is_blank(char ch) { return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n'; }
+static inline bool is_digit(char ch) { return ch >= '0' && ch <= '9'; }
+long KillVectorProducer::deriveMID(const char *& beg, const char * end) const {
+	while (beg < end && is_blank(*beg)) beg++;
 
-	while (index < n) {
-		ch = line[index];
-		if (ch != ' ' && ch != '\t' && ch != '\r' && ch != '\n') break;
-		else index++;
-	}
-
-	while (index < n) {
-		ch = line[index];
-		if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n')
-			break;
-		else { index++; token += ch; }
-	}
+	bool negative = false;
+	if (beg < end && (*beg == '-' || *beg == '+')) negative = (*(beg++) == '-');
+	if (beg == end || !is_digit(*beg)) return -1;
 
-	return token;
+	long mid = 0;
+	while (beg < end && is_digit(*beg)) mid = mid * 10 + (*(beg++) - '0');
+	return negative ? -mid : mid;
 }
-long KillVectorProducer::deriveMID(const std::string & line) {
-	int index = 0; long mid = -1;
-	std::string token = nextToken(line, index);
-	if (!token.empty()) 
-		mid = std::stol(token);
-	return mid;
-}
-bool KillVectorProducer::deriveKillSet(const std::string & line) {
-	int index = line.find(':', 0), n = line.length();
-	std::string token; BitSeq::size_t tid; 
-	if (index < 0) return false;
+bool KillVectorProducer::deriveKillSet(const char * beg, const char * end, KillVector & vec) {
+	const char * index = (const char *)memchr(beg, ':', end - beg);
+	if (index == nullptr) return false;
+
+	/* tokens of tests begin with 't' right after ':' or a blank (memchr finds 't' by SIMD) */
+	index++;
+	while (index < end) {
+		const char * token = (const char *)memchr(index, 't', end - index);
+		if (token == nullptr) break;
+		index = token + 1;
+		if (!is_blank(token[-1]) && token[-1] != ':') continue;
+
+		BitSeq::size_t tid = 0; const char * digits = index;
+		while (index < end && is_digit(*index)) tid = tid * 10 + (*(index++) - '0');
+		if (index == digits) continue;
 
-	index++; killset.clear();
-	while (index < n) {
-		token = this->nextToken(line, index);
-		if (token.empty()) continue;
-		if (token[0] != 't') continue;
-		token = token.substr(1);
-		tid = std::stoul(token);
-		killset.push_back(tid - bias);
+		tid -= bias;
+		if (vec.vector.get_bit(tid) == BIT_0) {
+			vec.vector.set_bit(tid, BIT_1);
+			killset.push_back(tid); vec.quantity++;
+		}
 	}
 
 	return true;
 }
+bool KillVectorProducer::produce(const char * beg, const char * end, KillVector & vec) {
+	if (vec.vector.bit_number() != testnum) throw "Invalid kill-vector length: ", vec.vector.bit_number();
+
+	/* clear the tests of the last line rather than the whole vector */
+	for (auto tid : killset) vec.vector.set_bit(tid, BIT_0);
+	killset.clear(); vec.quantity = 0; vec.mid = -1;
+
+	long mid = this->deriveMID(beg, end);
+	if (mid < 0) return false;
+	if (!this->deriveKillSet(beg, end, vec)) return false;
+	vec.mid = mid; return true;
+}
 const KillVector * KillVectorProducer::produce(const std::string & line) {
-	long mid = this->deriveMID(line);
-	if (mid >= 0) {
-		if (this->deriveKillSet(line)) {
-			return new KillVector(mid, testnum, killset);
-		}
-	}
-	return nullptr;
+	/* keep tests of the reused vector (if any) apart from the new one */
+	std::vector<BitSeq::size_t> reused; reused.swap(killset);
+	KillVector * vec = new KillVector(testnum);
+	bool valid = this->produce(line.data(), line.data() + line.length(), *vec);
+	killset.swap(reused);
+
+	if (valid) return vec;
+	else { delete vec; return nullptr; }
 }
 
 // BitTrie
-BitTrie::BitTrie(BitSeq::size_t bias_index, const BitSeq & partial_key)
-	: bias(bias_index), left(nullptr), right(nullptr), parent(nullptr), data(nullptr) {
-	key = new BitSeq(partial_key);
+/* index of the first different bit of a and b in [from, to) (to if none) */
+static BitSeq::size_t first_mismatch(const word * a, const word * b, BitSeq::size_t from, BitSeq::size_t to) {
+	if (from >= to) return to;
+	BitSeq::size_t k = from / WORD_BITS;
+	word diff = (a[k] ^ b[k]) & (~0ULL << (from % WORD_BITS));
+	while (diff == 0) {
+		if ((++k) * WORD_BITS >= to) return to;
+		diff = a[k] ^ b[k];
+	}
+	BitSeq::size_t index = k * WORD_BITS + word_ctz(diff);
+	return index < to ? index : to;
 }
-BitTrie::~BitTrie() { delete key;  }
+BitTrie::BitTrie(BitSeq::size_t bias_index, BitSeq::size_t key_length, const word * key_source)
+	: bias(bias_index), length(key_length), source(key_source), 
+	left(nullptr), right(nullptr), parent(nullptr), data(nullptr) {}
 BitSeq::size_t BitTrie::get_bias() const { return bias; }
-const BitSeq & BitTrie::get_key() const { return *key; }
+BitSeq BitTrie::get_key() const { 
+	BitSeq key(length);
+	for (BitSeq::size_t i = 0; i < length; i++) {
+		BitSeq::size_t k = bias + i;
+		key.set_bit(i, ((source[k / WORD_BITS] >> (k % WORD_BITS)) & 1ULL) != 0);
+	}
+	return key;
+}
 BitTrie * BitTrie::get_left() const { return left; }
 BitTrie * BitTrie::get_right() const { return right; }
 BitTrie * BitTrie::get_parent() const { return parent; }
@@ -218,41 +617,31 @@ void * BitTrie::get_data() const { return data; }
 void BitTrie::set_data(void * value) { data = value; }
 
 // BitTrieTree
-BitTrieTree::BitTrieTree() : root(nullptr) {}
-BitTrieTree::~BitTrieTree() {
-	std::queue<BitTrie *> queue;
-	if (root != nullptr) {
-		queue.push(root);
-		while (!queue.empty()) {
-			BitTrie * node = queue.front();
-			if (node->get_left() != nullptr) queue.push(node->get_left());
-			if (node->get_right() != nullptr) queue.push(node->get_right());
-			queue.pop(); delete node;
-		}
-	}
-}
+BitTrieTree::BitTrieTree() : root(nullptr), arena() {}
+BitTrieTree::~BitTrieTree() { root = nullptr; arena.clear(); }
 BitTrie * BitTrieTree::get_root() const { return root; }
+BitTrie * BitTrieTree::new_node(BitSeq::size_t bias, BitSeq::size_t length, const word * source) {
+	return new (arena.allocate_bytes(sizeof(BitTrie))) BitTrie(bias, length, source);
+}
 BitTrie * BitTrieTree::maximum_prefix_match(const BitSeq & seq, BitSeq::size_t & index) const {
 	// initialization 
 	index = 0; BitTrie * node = root, * next; 
-	int i, seql, keyl; bit seqi, keyi;
+	BitSeq::size_t seql = seq.bit_number(), keyend;
+	const word * words = seq.get_words();
 
 	// match from 0 to specific node
-	seql = seq.bit_number(); 
 	while (node != nullptr) {
-		/* match the bits in current node.key */
-		keyl = (node->get_key()).bit_number();
-		for (i = 0; i < keyl && index < seql; i++, index++) {
-			seqi = seq.get_bit(index);
-			keyi = (node->get_key()).get_bit(i);
-			if (seqi != keyi) { break; }
-		}
+		/* match the bits in current node.key word by word */
+		keyend = node->bias + node->length;
+		if (keyend > seql) keyend = seql;
+		index = first_mismatch(words, node->source, index, keyend);
 
 		/* not all-matched for this node or all-matched */
-		if (i < keyl || index >= seql) break;
+		if (index < keyend || index >= seql) break;
 		/* all-matched for this node but not completed, to the next level */
 		else {
-			seqi = seq.get_bit(index++);
+			bool seqi = ((words[index / WORD_BITS] >> (index % WORD_BITS)) & 1ULL) != 0;
+			index++;
 			if (seqi) next = node->get_right();
 			else next = node->get_left();
 
@@ -265,6 +654,10 @@ BitTrie * BitTrieTree::maximum_prefix_match(const BitSeq & seq, BitSeq::size_t &
 	return node;
 }
 BitTrie * BitTrieTree::get_leaf(const BitSeq & seq) const {
+	if (seq.is_sparse()) {
+		BitSeq dense(seq); dense.expand();
+		return get_leaf(dense);
+	}
 	BitSeq::size_t index = 0;
 	BitTrie * leaf = this->maximum_prefix_match(seq, index);
 	if (leaf != nullptr && index >= seq.bit_number())
@@ -272,42 +665,37 @@ BitTrie * BitTrieTree::get_leaf(const BitSeq & seq) const {
 	else return nullptr;
 }
 BitTrie * BitTrieTree::insert_vector(const BitSeq & seq) {
+	/* keys are matched against words */
+	if (seq.is_sparse()) {
+		BitSeq dense(seq); dense.expand();
+		return insert_vector(dense);
+	}
+
+	BitSeq::size_t index = 0, bit_num = seq.bit_number();
+	BitTrie * node = nullptr;
+	if (root != nullptr) {
+		node = maximum_prefix_match(seq, index);
+		if (index >= bit_num) return node;
+	}
+
+	/* copy the words of new sequence as source of its leaf */
+	BitSeq::size_t n = (bit_num + WORD_BITS - 1) / WORD_BITS;
+	word * source = arena.allocate(n);
+	for (BitSeq::size_t k = 0; k < n; k++) source[k] = seq.get_words()[k];
+
 	if (root == nullptr) {
-		root = new BitTrie(0, seq);
+		root = new_node(0, bit_num, source);
 		return root;
 	}
 	else {
-		BitSeq::size_t index, bit_num = seq.bit_number();
-		BitTrie * node = maximum_prefix_match(seq, index);
-		if (index >= bit_num) return node;
-
-		// get N, P, C1, C2
+		/* 
+		*	split N at the mismatched bit into prev (N1) and N itself (as post N2), 
+		*	N1 takes N's place with children N2 and new leaf L
+		* */
 		BitTrie * parent = node->get_parent();
-		BitTrie * lchild = node->get_left();
-		BitTrie * rchild = node->get_right();
-
-		// create prev, ori_post, new_post
-		const BitSeq & key = node->get_key();
-		BitSeq::size_t bias = index - (node->get_bias());
-		BitSeq prev = key.subseq(0, bias);
-		BitSeq ori_post = key.subseq(bias + 1, key.bit_number());
-		BitSeq new_post = seq.subseq(index + 1, seq.bit_number());
-		bit branch = seq.get_bit(index);
-
-		// create N1, N2, L
-		BitTrie * prev_node = new BitTrie(node->get_bias(), prev);
-		BitTrie * post_node = new BitTrie(index + 1, ori_post);
-		BitTrie * new_leaf = new BitTrie(index + 1, new_post);
-
-		// connect N1 to N2 and L
-		if (branch) {
-			prev_node->set_left(post_node);
-			prev_node->set_right(new_leaf);
-		}
-		else {
-			prev_node->set_left(new_leaf);
-			prev_node->set_right(post_node);
-		}
+		BitTrie * prev_node = new_node(node->bias, index - node->bias, node->source);
+		BitTrie * new_leaf = new_node(index + 1, bit_num - index - 1, source);
+		bool branch = ((source[index / WORD_BITS] >> (index % WORD_BITS)) & 1ULL) != 0;
 
 		// connect N1 to P
 		if (parent != nullptr) {
@@ -316,20 +704,21 @@ BitTrie * BitTrieTree::insert_vector(const BitSeq & seq) {
 			else 
 				parent->set_right(prev_node);
 		}
-		
-		// connect N2 to C1 and C2
-		post_node->set_left(lchild);
-		post_node->set_right(rchild);
-
-		// maintain the data
-		if (node->data != nullptr) {
-			post_node->data = node->data;
-		}
+		else root = prev_node;
 
-		// remove node and update tree
-		if (node == root)
-			root = prev_node;
-		delete node;
+		// N keeps its children and data as the post part of key
+		node->length = node->bias + node->length - index - 1;
+		node->bias = index + 1;
+
+		// connect N1 to N2 and L
+		if (branch) {
+			prev_node->set_left(node);
+			prev_node->set_right(new_leaf);
+		}
+		else {
+			prev_node->set_left(new_leaf);
+			prev_node->set_right(node);
+		}
 
 		// return 
 		return new_leaf;
@@ -341,4 +730,73 @@ void printTrieTree(const BitTrie & node, std::ostream & out, const std::string &
 		printTrieTree(*(node.get_left()), out, prefix + "|-- ");
 		printTrieTree(*(node.get_right()), out, prefix + "|-- ");
 	}
-}
\ No newline at end of file
+}
+
+// BitHashTable
+BitHashTable::BitHashTable() : bit_num(0), stride(0), slots(), entries(), pool() {}
+BitHashTable::~BitHashTable() {}
+size_t BitHashTable::probe(const word * data, word hash) const {
+	size_t mask = slots.size() - 1, k = hash & mask;
+	while (true) {
+		const Slot & slot = slots[k];
+		if (slot.entry == 0) return k;
+		else if (slot.hash == hash) {
+			const word * ws = pool.data() + entries[slot.entry - 1].offset;
+			bool same = (stride == VECTOR_WORDS) ? fixed_equals<VECTOR_WORDS>(ws, data) 
+				: bit_kernels->equals(ws, data, stride);
+			if (same) return k;
+		}
+		k = (k + 1) & mask;
+	}
+}
+void BitHashTable::grow() {
+	size_t n = slots.empty() ? 64 : slots.size() * 2;
+	slots.assign(n, Slot());
+	for (size_t i = 0; i < entries.size(); i++) {
+		size_t k = entries[i].hash & (n - 1);
+		while (slots[k].entry != 0) k = (k + 1) & (n - 1);
+		slots[k].hash = entries[i].hash;
+		slots[k].entry = i + 1;
+	}
+}
+BitHashEntry * BitHashTable::insert_vector(const BitSeq & seq) {
+	/* sparse sequences are compared by their words */
+	if (seq.is_sparse()) {
+		BitSeq dense(seq); dense.expand();
+		return insert_vector(dense);
+	}
+
+	if (entries.empty() && pool.empty()) {
+		bit_num = seq.bit_number(); stride = seq.word_number();
+	}
+	else if (seq.bit_number() != bit_num)
+		throw "Invalid length: ", seq.bit_number(), " ( expected ", bit_num, " )";
+
+	/* keep load factor under 1/2 */
+	if ((entries.size() + 1) * 2 > slots.size()) grow();
+
+	word hash = seq.hash();
+	size_t k = probe(seq.get_words(), hash);
+	if (slots[k].entry != 0) 
+		return &entries[slots[k].entry - 1];
+
+	/* create a new cluster */
+	BitHashEntry entry;
+	entry.hash = hash; entry.offset = pool.size(); entry.data = nullptr;
+	pool.insert(pool.end(), seq.get_words(), seq.get_words() + stride);
+	entries.push_back(entry);
+	slots[k].hash = hash;
+	slots[k].entry = entries.size();
+	return &entries.back();
+}
+BitHashEntry * BitHashTable::get_entry(const BitSeq & seq) const {
+	if (seq.is_sparse()) {
+		BitSeq dense(seq); dense.expand();
+		return get_entry(dense);
+	}
+	if (slots.empty() || seq.bit_number() != bit_num) return nullptr;
+
+	size_t k = probe(seq.get_words(), seq.hash());
+	if (slots[k].entry == 0) return nullptr;
+	else return const_cast<BitHashEntry *>(&entries[slots[k].entry - 1]);
+}
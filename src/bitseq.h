@@ -11,10 +11,15 @@
 		[2] class KillVector;
 		[3] class BitTrie;
 		[4] class BitTrieTree;
+		[5] class BitHashEntry;
+		[6] class BitHashTable;
 */
 
+#include "bitops.h"
 #include <string>
 #include <list>
+#include <vector>
+#include <deque>
 
 /* a bit is either 0 (false) or 1 (true) */
 typedef bool bit;
@@ -34,19 +39,59 @@ class KillVector;
 class KillVectorProducer;
 class BitTrie;
 class BitTrieTree;
+class BitHashEntry;
+class BitHashTable;
 
-/* Sequence of bits */
+/* 
+*	Sequence of bits. Sequences of at most INLINE_BITS bits keep their words
+*	inside the object (no heap allocation), longer ones on an aligned heap block.
+*	A long sequence with few bit-1 can be compacted into a sparse sequence, which
+*	keeps the sorted indexes of its bit-1 instead of words; every operation
+*	accepts dense and sparse sequences on either side.
+* */
 class BitSeq {
 public:
 	/* integer to access bit in BitSeq */
 	typedef unsigned int size_t;
+	/* maximum number of bits maintained without heap allocation */
+	static const size_t INLINE_BITS = VECTOR_WORDS * WORD_BITS;
 
 	/* construct from another bit sequence */
 	BitSeq(const BitSeq &);
+	/* take the words of another bit sequence */
+	BitSeq(BitSeq &&) noexcept;
 	/* construct a all-zero bit sequence of specified length */
 	BitSeq(size_t);
-	/* release dynamically allocated bytes in the sequence */
+	/* release dynamically allocated words in the sequence */
 	~BitSeq();
+	/* copy another bit sequence into this one */
+	BitSeq & operator = (const BitSeq &);
+	/* take the words of another bit sequence */
+	BitSeq & operator = (BitSeq &&) noexcept;
+
+	/* whether the sequence keeps indexes of bit-1 instead of words */
+	bool is_sparse() const { return sparse; }
+	/* turn into sparse sequence when it takes less memory than words */
+	void compact();
+	/* turn into dense sequence (words) */
+	void expand();
+	/* sorted indexes of bit-1 in a sparse sequence (count() items) */
+	const unsigned int * get_positions() const { return items.data(); }
+	/* turn into sparse sequence with the sorted indexes of its bit-1 */
+	void set_positions(const unsigned int *, size_t);
+	/* turn into dense sequence with the first n (at most bits / 64) words copied, others are zero */
+	void set_words(const word *, size_t n);
+	/* move the words into source (word_number() words aligned to vector width, owned by others), 
+	where the bits are kept and changed from now on until the sequence is resized (dense only) */
+	void borrow(word * source);
+	/* whether the words are owned by others */
+	bool is_borrowed() const { return borrowed; }
+	/* copy the borrowed words into a block owned by this sequence (nothing if not borrowed) */
+	void unborrow();
+	/* hash of the bit-1 in sequence (the same for dense and sparse sequences) */
+	word hash() const;
+	/* OR of all words: bit i is 1 if some bit-1 has index i modulo 64 (the same for dense and sparse sequences) */
+	word fold() const;
 
 	/* get the number of bits occupied by the sequence */
 	size_t bit_number() const;
@@ -55,36 +100,112 @@ public:
 	/* set the ith bit in sequence */
 	void set_bit(size_t, bit);
 
-	/* update this sequence to another conjunction */
+	/* this = this & y (bits missing in y are 0) */
 	void conjunct(const BitSeq &);
-	/* whether this sequence subsumes another */
-	bool subsume(const BitSeq &) const;
+	/* this = this | y */
+	void disjunct(const BitSeq &);
+	/* this = this ^ y */
+	void differ(const BitSeq &);
+	/* this = this & ~y */
+	void exclude(const BitSeq &);
+
+	/* whether this sequence subsumes another (every bit-1 in this is bit-1 in y) */
+	bool subsume(const BitSeq & y) const {
+		/* sparse sequences have no words (length == 0) */
+		if (length == VECTOR_WORDS && y.length == VECTOR_WORDS)
+			return fixed_subsume<VECTOR_WORDS>(words, y.words);
+		else return subsume_words(y);
+	}
+	/* the same as subsume(y): whether this is a subset of y */
+	bool is_subset_of(const BitSeq & y) const { return subsume(y); }
+	/* whether this and y share any bit-1 */
+	bool intersects(const BitSeq &) const;
+	/* whether the bits in two sequences are the same */
+	bool equals(const BitSeq & y) const {
+		if (bit_num != y.bit_num) return false;
+		else if (length == VECTOR_WORDS && y.length == VECTOR_WORDS)
+			return fixed_equals<VECTOR_WORDS>(words, y.words);
+		else return equals_words(y);
+	}
+
+	/* number of bit-1 in the sequence */
+	size_t count() const;
+	/* whether there is any bit-1 in the sequence */
+	bool any() const;
+	/* whether all bits in the sequence are 0 */
+	bool none() const { return !any(); }
+	/* index of the first bit-1 (bit_number() if none) */
+	size_t first_bit() const;
+	/* index of the first bit-1 after the ith bit (bit_number() if none) */
+	size_t next_bit(size_t) const;
 
 	/* converse the sequence to string */
 	std::string to_string() const;
 
-	/* number of bytes occupied by this sequence */
+	/* number of bytes occupied by this sequence (dense only) */
 	int byte_number() const;
-	/* sequence of bytes to store bit-sequence */
+	/* sequence of bytes to store bit-sequence, words in little-endian order (dense only) */
 	byte * get_bytes() const;
-	/* set the bytes in sequence with specified bytes (from 0 to max(length, slength) */
+	/* set the bytes in sequence with specified bytes (from 0 to max(length, slength) (dense only) */
 	void set_bytes(const byte *, size_t); 
 
+	/* number of words allocated for this sequence, padded to vector width (0 if sparse) */
+	size_t word_number() const { return length; }
+	/* words to store bit-sequence (heap blocks are aligned to vector width, inline words only to 
+	the object), padding bits are 0 (dense only) */
+	const word * get_words() const { return words; }
+
 	/* get the sub-bit-sequence within given range */
 	BitSeq subseq(size_t, size_t) const;
 private:
 	/* number of bits */
 	size_t bit_num;
-	/* length of bytes */
+	/* length of words (multiple of VECTOR_WORDS, 0 if sparse) */
 	size_t length;
-	/* bytes where bits are maintained */
-	byte * bytes;
+	/* words where bits are maintained (local or heap) */
+	word * words;
+	/* whether bits are maintained as sorted indexes in items */
+	bool sparse;
+	/* whether words are owned by others (not released) */
+	bool borrowed;
+	union {
+		/* inline words for short dense sequences */
+		word local[VECTOR_WORDS];
+		/* sorted indexes of bit-1 in sparse sequence (constructed only while sparse) */
+		std::vector<unsigned int> items;
+	};
+
+	/* point words to local or heap block for length */
+	void allocate();
+	/* release heap block (if any, and not borrowed) */
+	void release();
+	/* release words and construct empty items in their place (nothing if sparse) */
+	void to_sparse();
+	/* destroy items, leaving a dense sequence of no words (nothing if dense) */
+	void to_dense();
+	/* whether this sequence subsumes another (by kernels or indexes) */
+	bool subsume_words(const BitSeq &) const;
+	/* whether two sequences of the same length are equal (by kernels or indexes) */
+	bool equals_words(const BitSeq &) const;
+	/* whether the ith bit is 1 (false when out of range) */
+	bool has(size_t) const;
+	/* clear the bits beyond bit_num in words */
+	void trim();
+	/* index of the first bit-1 from the kth word on (bit_num if none) */
+	size_t scan_from(size_t k, word) const;
 };
+/* out-of-place operations, the result has the length of the left operand */
+BitSeq operator & (const BitSeq &, const BitSeq &);
+BitSeq operator | (const BitSeq &, const BitSeq &);
+BitSeq operator ^ (const BitSeq &, const BitSeq &);
+BitSeq operator - (const BitSeq &, const BitSeq &);
 /* vector to represent tests that kill mutant */
 class KillVector {
 public:
 	/* create a kill-vector for mutant mid with length testnum */
-	KillVector(long mid, BitSeq::size_t testnum, const std::list<BitSeq::size_t> & killset);
+	KillVector(long mid, BitSeq::size_t testnum, const std::vector<BitSeq::size_t> & killset);
+	/* create an empty kill-vector of length testnum, to be reused by KillVectorProducer */
+	KillVector(BitSeq::size_t testnum);
 	/* release memory for vector in the kill-vector */
 	~KillVector();
 
@@ -104,41 +225,53 @@ private:
 	int quantity;
 	/* bit-sequence to present the kill-set */
 	BitSeq vector;
-	
+
+	friend class KillVectorProducer;
+	friend class KillMatrixReader;
 };
 /* to produce kill-vector by interpreting line text from results */
 class KillVectorProducer {
 private:
 	BitSeq::size_t bias;
 	BitSeq::size_t testnum;
-	std::list<BitSeq::size_t> killset;
+	/* tests set in the reused vector by the last line (to clear them) */
+	std::vector<BitSeq::size_t> killset;
 
-	std::string nextToken(const std::string &, int &) const;
-	long deriveMID(const std::string & line);
-	bool deriveKillSet(const std::string & line);
+	/* parse the mutant id at the head of line in [beg, end) (-1 if none) */
+	long deriveMID(const char *& beg, const char * end) const;
+	/* set bits of the tests in kill-set after ':' in [beg, end), return false if no ':' */
+	bool deriveKillSet(const char * beg, const char * end, KillVector & vec);
 public:
 	//KillVectorProducer(BitSeq::size_t testnum);
 	KillVectorProducer(BitSeq::size_t testnum, BitSeq::size_t bias);
+	/* create a new kill-vector from line (nullptr if it is not a kill-vector) */
 	const KillVector * produce(const std::string & line);
+	/* overwrite vec (created by KillVector(testnum)) from text in [beg, end) without allocation, false if it is not a kill-vector */
+	bool produce(const char * beg, const char * end, KillVector & vec);
 };
 
-/* Binary trie for bit-sequence */
+/* 
+*	Binary trie for bit-sequence. The key of a node is a view on the bits
+*	[bias, bias + length) of a sequence inserted to the tree (source).
+* */
 class BitTrie {
 protected:
 	/* set left child */
 	void set_left(BitTrie *);
 	/* set right child */
 	void set_right(BitTrie *);
+	/* construct a leaf node without data and children by its start-index, key-length and source words */
+	BitTrie(BitSeq::size_t, BitSeq::size_t, const word *);
 public:
-	/* construct a leaf node without data and children by specifying its start-index and key-sequence */
-	BitTrie(BitSeq::size_t, const BitSeq &);
-	/* release the key sequence (not data, left and right) */
-	~BitTrie();
+	/* nodes are released by the arena of their tree */
+	~BitTrie() {}
 
 	/* get the index to the first bit which it's going to match */
 	BitSeq::size_t get_bias() const;
-	/* get the key in this sequence */
-	const BitSeq & get_key() const;
+	/* get the number of bits in key */
+	BitSeq::size_t get_key_length() const { return length; }
+	/* get the key in this sequence (copied from its source) */
+	BitSeq get_key() const;
 
 	/* get the left child */
 	BitTrie * get_left() const;
@@ -160,8 +293,10 @@ public:
 private:
 	/* index to the first bit matched by this node */
 	BitSeq::size_t bias;
-	/* partial key to match bit-sequence from index to index + key.bit_number() - 1 */
-	BitSeq * key;
+	/* number of bits in key: it matches bit-sequence from bias to bias + length - 1 */
+	BitSeq::size_t length;
+	/* words of the sequence where the key is taken from */
+	const word * source;
 	/* left child */
 	BitTrie * left;
 	/* right child */
@@ -171,7 +306,7 @@ private:
 	/* data item referred by this node */
 	void * data;
 };
-/* Tree for bit-trie */
+/* Tree for bit-trie, whose nodes and sources are allocated in one arena */
 class BitTrieTree {
 public:
 	/* construct an empty trie tree */
@@ -189,10 +324,79 @@ public:
 	BitTrie * insert_vector(const BitSeq &);
 	/* get the leaf referring to the bit-sequence */
 	BitTrie * get_leaf(const BitSeq &) const;
+	/* number of bytes allocated for nodes and sources */
+	size_t memory() const { return arena.footprint(); }
 
 private:
 	/* the root of this tree */
 	BitTrie * root;
+	/* arena of nodes and copies of inserted sequences */
+	WordArena arena;
 	/* match to the maximum prefix of sequence in the trie */
 	BitTrie * maximum_prefix_match(const BitSeq &, BitSeq::size_t &) const;
+	/* create a node in arena */
+	BitTrie * new_node(BitSeq::size_t, BitSeq::size_t, const word *);
+};
+
+/* cluster of identical bit-sequences in hash table */
+class BitHashEntry {
+public:
+	/* get the hash of sequences in this cluster */
+	word get_hash() const { return hash; }
+	/* get the data (null when the cluster is created) */
+	void * get_data() const { return data; }
+	/* set the data */
+	void set_data(void * value) { data = value; }
+
+	friend class BitHashTable;
+private:
+	/* hash of sequences in this cluster */
+	word hash;
+	/* offset of the words of sequence in table pool */
+	size_t offset;
+	/* data item referred by this cluster */
+	void * data;
+};
+/* 
+*	Open-addressing (linear probing) table to cluster identical bit-sequences.
+*	Words of sequences are copied inline into one pool; a hash hit is confirmed
+*	by comparing the full words. All sequences must have the same bit number.
+* */
+class BitHashTable {
+public:
+	/* construct an empty table */
+	BitHashTable();
+	/* release the slots and pool */
+	~BitHashTable();
+
+	/* number of clusters in the table */
+	size_t size() const { return entries.size(); }
+	/* 
+	*  insert another bit-sequence into the table
+	*	1) if some cluster refers to the bits, then it is returned;
+	*	2) otherwise, a new cluster (without data) is created and returned.
+	*/
+	BitHashEntry * insert_vector(const BitSeq &);
+	/* get the cluster referring to the bit-sequence (null if none) */
+	BitHashEntry * get_entry(const BitSeq &) const;
+
+private:
+	/* slot in the table: hash and index of entry + 1 (0 for empty) */
+	struct Slot { word hash; size_t entry; };
+
+	/* number of bits in each sequence */
+	BitSeq::size_t bit_num;
+	/* number of words of each sequence in pool */
+	size_t stride;
+	/* slots of table (power of 2) */
+	std::vector<Slot> slots;
+	/* clusters (stable addresses) */
+	std::deque<BitHashEntry> entries;
+	/* words of sequences (stride words per cluster) */
+	std::vector<word> pool;
+
+	/* find the slot for words of hash (empty slot if not found) */
+	size_t probe(const word *, word) const;
+	/* double the slots and re-insert clusters */
+	void grow();
 };
@@ -0,0 +1,135 @@
+#include "classify.h"
+#include "text.h"
+#include <cstring>
+#include <atomic>
+
+// KillVectorClassifier
+KillVectorClassifier::KillVectorClassifier(DMSGraphBuilder & b, BitSeq::size_t tnum, BitSeq::size_t _bias, bool trie)
+	: builder(b), testnum(tnum), bias(_bias), by_trie(trie), tree(nullptr), table(nullptr),
+	producer(tnum, _bias), buffer(tnum), vectors(0), killed(0) {
+	if (by_trie) tree = new BitTrieTree();
+	else table = new BitHashTable();
+}
+KillVectorClassifier::~KillVectorClassifier() {
+	if (tree != nullptr) delete tree;
+	if (table != nullptr) delete table;
+	tree = nullptr; table = nullptr;
+}
+DMSGVertex * KillVectorClassifier::cluster(const KillVector & vec) {
+	/* get the leaf (or cluster) for this vector */
+	BitTrie * leaf = nullptr; BitHashEntry * entry = nullptr; void * data;
+	if (by_trie) {
+		leaf = tree->insert_vector(vec.get_vector());
+		if (leaf == nullptr) throw "Interpreting error!";
+		data = leaf->get_data();
+	}
+	else {
+		entry = table->insert_vector(vec.get_vector());
+		data = entry->get_data();
+	}
+
+	/* The first time it is created */
+	if (data == nullptr) {
+		DMSGVertex * vex = builder.add_node(vec);
+		if (by_trie) leaf->set_data(vex);
+		else entry->set_data(vex);
+		return vex;
+	}
+	/* The second or other time is only linked to mutant */
+	else {
+		DMSGVertex * vex = (DMSGVertex *)data;
+		builder.add_index(vec.get_mutant_ID(), *vex);
+		return vex;
+	}
+}
+void KillVectorClassifier::classify(const KillVector & vec) {
+	this->cluster(vec);
+	vectors++;
+	if (vec.get_quantity() > 0) killed++;
+}
+size_t KillVectorClassifier::block_characters(unsigned int threads) {
+	size_t block = (size_t)threads * 2 * MinimumChunkCharacters;
+	return block < BlockReader::DefaultBlockCharacters ? BlockReader::DefaultBlockCharacters : block;
+}
+void KillVectorClassifier::classify(const char * beg, const char * end, unsigned int threads) {
+	/* split the text at line boundaries (several chunks per thread to balance the load) */
+	std::vector<Chunk> chunks;
+	size_t size = end - beg, step = size / ((size_t)threads * 4 + 1);
+	if (step < MinimumChunkCharacters) step = MinimumChunkCharacters;
+	while (beg < end) {
+		const char * tail = end;
+		if ((size_t)(end - beg) > step) {
+			tail = (const char *)memchr(beg + step, '\n', end - beg - step);
+			tail = (tail == nullptr) ? end : tail + 1;
+		}
+		chunks.push_back(Chunk());
+		chunks.back().beg = beg; chunks.back().end = tail;
+		beg = tail;
+	}
+
+	/* a single chunk is classified line by line */
+	if (threads <= 1 || chunks.size() <= 1) {
+		for (size_t k = 0; k < chunks.size(); k++) {
+			const char * cursor = chunks[k].beg, * tail = chunks[k].end;
+			while (cursor < tail) {
+				const char * eol = (const char *)memchr(cursor, '\n', tail - cursor);
+				if (eol == nullptr) eol = tail;
+				bool valid = producer.produce(cursor, eol, buffer);
+				cursor = eol + 1;
+				if (valid) this->classify(buffer);
+			}
+		}
+		return;
+	}
+
+	/* parse I: threads take chunks one by one and cluster them locally */
+	if (threads > chunks.size()) threads = chunks.size();
+	std::atomic<size_t> next(0);
+	run_threads(threads, [this, &chunks, &next](unsigned int) {
+		size_t k;
+		while ((k = next++) < chunks.size())
+			this->parse_chunk(chunks[k]);
+	});
+
+	/* parse II: merge the chunks in order */
+	for (size_t k = 0; k < chunks.size(); k++) {
+		this->merge_chunk(chunks[k]);
+		Chunk().clusters.swap(chunks[k].clusters);
+	}
+}
+void KillVectorClassifier::parse_chunk(Chunk & chunk) const {
+	KillVectorProducer local_producer(testnum, bias);
+	KillVector vec(testnum); BitHashTable local;
+	chunk.killed = 0;
+
+	const char * cursor = chunk.beg, * tail = chunk.end;
+	while (cursor < tail) {
+		const char * eol = (const char *)memchr(cursor, '\n', tail - cursor);
+		if (eol == nullptr) eol = tail;
+		bool valid = local_producer.produce(cursor, eol, vec);
+		cursor = eol + 1;
+		if (!valid) continue;
+
+		/* local cluster id + 1 is kept as data of entry */
+		BitHashEntry * entry = local.insert_vector(vec.get_vector());
+		if (entry->get_data() == nullptr) {
+			chunk.clusters.push_back(vec);
+			entry->set_data((void *)chunk.clusters.size());
+		}
+		chunk.mutants.push_back(std::pair<long, size_t>(
+			vec.get_mutant_ID(), (size_t)entry->get_data() - 1));
+		if (vec.get_quantity() > 0) chunk.killed++;
+	}
+}
+void KillVectorClassifier::merge_chunk(const Chunk & chunk) {
+	/* the first mutant of a local cluster is the one of its kill-vector */
+	std::vector<DMSGVertex *> vertices(chunk.clusters.size(), nullptr);
+	for (size_t i = 0; i < chunk.mutants.size(); i++) {
+		long mid = chunk.mutants[i].first; size_t k = chunk.mutants[i].second;
+		if (vertices[k] == nullptr)
+			vertices[k] = this->cluster(chunk.clusters[k]);
+		else builder.add_index(mid, *vertices[k]);
+	}
+	vectors += chunk.mutants.size();
+	killed += chunk.killed;
+}
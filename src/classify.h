@@ -0,0 +1,80 @@
+#pragma once
+/*
+	File: classify.h
+	-Aim: to cluster kill-vectors parsed from score function into vertices of DMSG builder
+	-Dat: Oct 16th, 2026
+	-Art: Lin Huan
+	-Cls:
+		[1] KillVectorClassifier
+*/
+
+#include "dmsg.h"
+#include <vector>
+
+class KillVectorClassifier;
+
+/*
+*	Classifier to create a vertex in builder for each cluster of identical kill-vectors,
+*	and to index the mutants to their vertices. Text is split at line boundaries into
+*	chunks parsed and clustered locally by threads; the local clusters are merged in the
+*	order of chunks, so vertex ids and the index are the same as classifying line by line.
+* */
+class KillVectorClassifier {
+public:
+	/* minimum number of characters in a chunk parsed by one thread */
+	static const size_t MinimumChunkCharacters = 1 << 20;
+	/* number of characters in a streamed block to give each thread two chunks (at least the default block) */
+	static size_t block_characters(unsigned int threads);
+
+	/* create classifier for builder (opened), clustering by bit-trie or hash table */
+	KillVectorClassifier(DMSGraphBuilder & builder, BitSeq::size_t testnum, BitSeq::size_t bias, bool by_trie);
+	/* release the trie tree or hash table */
+	~KillVectorClassifier();
+
+	/* classify the lines of score function in [beg, end) by the specified number of threads */
+	void classify(const char * beg, const char * end, unsigned int threads);
+	/* classify one kill-vector */
+	void classify(const KillVector &);
+
+	/* number of kill-vectors classified */
+	unsigned int number_of_vectors() const { return vectors; }
+	/* number of kill-vectors killed by some test */
+	unsigned int number_of_killed() const { return killed; }
+
+private:
+	/* clusters of identical kill-vectors in one chunk */
+	struct Chunk {
+		/* range of characters */
+		const char * beg, * end;
+		/* the first kill-vector of each local cluster */
+		std::vector<KillVector> clusters;
+		/* mutants and their local clusters in line order */
+		std::vector<std::pair<long, size_t> > mutants;
+		/* number of kill-vectors killed by some test */
+		unsigned int killed;
+	};
+
+	/* builder where vertices are created */
+	DMSGraphBuilder & builder;
+	/* number of tests */
+	BitSeq::size_t testnum;
+	/* bias of test ids */
+	BitSeq::size_t bias;
+	/* whether to cluster by bit-trie (or hash table) */
+	bool by_trie;
+	/* clusters of all kill-vectors */
+	BitTrieTree * tree;
+	BitHashTable * table;
+	/* producer and reused kill-vector for serial parsing */
+	KillVectorProducer producer;
+	KillVector buffer;
+	/* counters */
+	unsigned int vectors, killed;
+
+	/* get the vertex of the cluster of kill-vector (created for the first one), and index its mutant */
+	DMSGVertex * cluster(const KillVector &);
+	/* parse and cluster lines of chunk locally */
+	void parse_chunk(Chunk &) const;
+	/* merge local clusters of chunk into builder */
+	void merge_chunk(const Chunk &);
+};
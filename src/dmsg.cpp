@@ -1,98 +1,218 @@
 #include "text.h"
 #include "dmsg.h"
 #include <algorithm>
+#include <new>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 #include <iostream>
 
 // DMSGVertex implement 
 DMSGVertex::DMSGVertex(long id, const BitSeq & vec, BitSeq::size_t deg)
-	: vid(id), vector(vec), degree(deg) {}
+	: vid(id), vector(vec), degree(deg), signature(vec.fold()) {}
 DMSGVertex::~DMSGVertex() {}
 
 // DMSGraph implement
-DMSGraph::DMSGraph() : roots(), leafs(), vertices() {}
+DMSGraph::DMSGraph() : roots(), leafs(), table(), vnum(0), matrix(), created(), arena(), in_lists(), ou_lists(),
+	frozen(false), out_offsets(), out_targets(), in_offsets(), in_sources(), root_list(), leaf_list() {}
 DMSGraph::~DMSGraph() { clear(); }
-bool DMSGraph::has_vertex(long id) const {
-	return vertices.count(id) > 0;
+DMSGVertex * DMSGraph::new_vertex(long id, const BitSeq & vec, BitSeq::size_t deg) {
+	DMSGVertex * vertex = new (arena.allocate_bytes(sizeof(DMSGVertex))) DMSGVertex(id, vec, deg);
+	created.push_back(vertex);
+	if ((size_t)id >= in_lists.size()) {
+		in_lists.resize(id + 1); ou_lists.resize(id + 1);
+	}
+	return vertex;
 }
 const DMSGVertex & DMSGraph::get_vertex(long id) const {
-	if (vertices.count(id) > 0) {
-		auto ptr = vertices.find(id);
-		return *(ptr->second);
-	}
+	if (has_vertex(id)) return *(table[id]);
 	else throw "Undefined vertex: ", id;
 }
 void DMSGraph::add(DMSGVertex & node) {
 	long vid = node.vid;
-	if (vertices.count(vid) == 0) {
-		vertices[vid] = &node;
-		if(node.in_degree() == 0) roots.insert(vid);
-		if(node.out_degree() == 0) leafs.insert(vid);
+	if (frozen) throw "Invalid access: frozen graph";
+	else if (vid < 0) throw "Invalid vid: ", vid;
+	else if (!has_vertex(vid)) {
+		if ((size_t)vid >= table.size()) table.resize(vid + 1, nullptr);
+		table[vid] = &node; vnum++;
+		if (in_lists[vid].empty()) roots.insert(vid);
+		if (ou_lists[vid].empty()) leafs.insert(vid);
 	}
 	else throw "Duplicated vid: ", vid;
 }
 void DMSGraph::link(DMSGVertex & source, DMSGVertex & target) {
 	long sid = source.get_id(), tid = target.get_id();
-	if (sid != tid) {
+	if (frozen) throw "Invalid access: frozen graph";
+	else if (sid != tid) {
 		DMSGSubsume edge(source, target);
-		source.ou_list.push_front(edge);
-		target.in_list.push_front(edge);
+		ou_lists[sid].push_front(edge);
+		in_lists[tid].push_front(edge);
 	}
 	else throw "Invalid connection: ", sid, " to ", tid;
 }
-void DMSGraph::clear() {
-	roots.clear(); leafs.clear();
-	auto beg = vertices.begin(), end = vertices.end();
+void DMSGraph::unlink(DMSGVertex & source, DMSGVertex & target) {
+	if (frozen) throw "Invalid access: frozen graph";
+	std::list<DMSGSubsume> & outs = ou_lists[source.vid], & ins = in_lists[target.vid];
+	auto beg = outs.begin(), end = outs.end();
+	while (beg != end) {
+		if (&(beg->get_target()) == &target) beg = outs.erase(beg);
+		else beg++;
+	}
+	beg = ins.begin(), end = ins.end();
 	while (beg != end) {
-		DMSGVertex * vertex = (beg++)->second;
-		if (vertex != nullptr) delete vertex;
+		if (&(beg->get_source()) == &source) beg = ins.erase(beg);
+		else beg++;
 	}
-	vertices.clear();
 }
-static std::set<long> remove_set;
-void DMSGraph::update_roots() {
-	/* initialization */
-	remove_set.clear();
+void DMSGraph::remove(DMSGVertex & node) {
+	long vid = node.vid;
+	if (frozen) throw "Invalid access: frozen graph";
+	else if (!has_vertex(vid) || table[vid] != &node) throw "Undefined vertex: ", vid;
+	else if (!in_lists[vid].empty() || !ou_lists[vid].empty()) throw "Invalid removal of linked vertex: ", vid;
+	else {
+		table[vid] = nullptr; vnum--;
+		roots.erase(vid); leafs.erase(vid);
+	}
+}
+void DMSGraph::update_ends(const DMSGVertex & node) {
+	long vid = node.vid;
+	if (in_lists[vid].empty()) roots.insert(vid);
+	else roots.erase(vid);
+	if (ou_lists[vid].empty()) leafs.insert(vid);
+	else leafs.erase(vid);
+}
+void DMSGraph::clear() {
+	roots.clear(); leafs.clear();
+	/* vertices borrow rows of matrix, and are released before it */
+	for (size_t k = 0; k < created.size(); k++)
+		created[k]->~DMSGVertex();
+	created.clear(); arena.clear();
+	table.clear(); vnum = 0;
+	in_lists.clear(); ou_lists.clear();
+	matrix.clear();
+
+	frozen = false;
+	out_offsets.clear(); out_targets.clear();
+	in_offsets.clear(); in_sources.clear();
+	root_list.clear(); leaf_list.clear();
+}
+void DMSGraph::freeze() {
+	if (frozen) return;
+	else if (table.size() > 0xFFFFFFFFUL)
+		throw "Too many vertices to freeze: ", table.size();
+
+	/* offsets of edges of each vertex */
+	size_t n = table.size();
+	out_offsets.assign(n + 1, 0); in_offsets.assign(n + 1, 0);
+	for (size_t v = 0; v < n; v++) {
+		bool absent = (table[v] == nullptr);
+		out_offsets[v + 1] = out_offsets[v] + (absent ? 0 : ou_lists[v].size());
+		in_offsets[v + 1] = in_offsets[v] + (absent ? 0 : in_lists[v].size());
+	}
 
-	/* collect invalid root */
-	auto beg = roots.begin(), end = roots.end();
-	while (beg != end) {
-		long vid = *(beg++);
-		auto iter = vertices.find(vid);
-		DMSGVertex & vex = *(iter->second);
-		if (vex.in_degree() > 0)
-			remove_set.insert(vid);
+	/* move edges into arrays (in the order of lists) */
+	out_targets.resize(out_offsets[n]); in_sources.resize(in_offsets[n]);
+	for (size_t v = 0; v < n; v++) {
+		if (table[v] == nullptr) continue;
+
+		unsigned int k = out_offsets[v];
+		auto beg = ou_lists[v].begin(), end = ou_lists[v].end();
+		while (beg != end) out_targets[k++] = (unsigned int)((beg++)->get_target().get_id());
+		k = in_offsets[v];
+		beg = in_lists[v].begin(), end = in_lists[v].end();
+		while (beg != end) in_sources[k++] = (unsigned int)((beg++)->get_source().get_id());
 	}
+	std::vector<std::list<DMSGSubsume> >().swap(ou_lists);
+	std::vector<std::list<DMSGSubsume> >().swap(in_lists);
 
-	/* remove invalid roots from this->roots */
-	beg = remove_set.begin(), end = remove_set.end();
+	/* roots and leafs in sorted vectors */
+	root_list.assign(roots.begin(), roots.end()); roots.clear();
+	leaf_list.assign(leafs.begin(), leafs.end()); leafs.clear();
+	frozen = true;
+}
+void DMSGraph::thaw() {
+	if (!frozen) return;
+
+	/* rebuild the lists in the order of arrays (vertices created since freeze() have lists already) */
+	size_t n = std::max(table.size(), in_lists.size());
+	in_lists.resize(n); ou_lists.resize(n);
+	for (size_t v = 0; v < table.size(); v++) {
+		DMSGVertex * vertex = table[v];
+		if (vertex == nullptr) continue;
+		for (unsigned int k = out_offsets[v]; k < out_offsets[v + 1]; k++)
+			ou_lists[v].push_back(DMSGSubsume(*vertex, *(table[out_targets[k]])));
+		for (unsigned int k = in_offsets[v]; k < in_offsets[v + 1]; k++)
+			in_lists[v].push_back(DMSGSubsume(*(table[in_sources[k]]), *vertex));
+	}
+	out_offsets.clear(); out_targets.clear();
+	in_offsets.clear(); in_sources.clear();
+
+	roots.insert(root_list.begin(), root_list.end()); root_list.clear();
+	leafs.insert(leaf_list.begin(), leaf_list.end()); leaf_list.clear();
+	frozen = false;
+}
+unsigned int DMSGraph::number_of_edges() const {
+	if (frozen) return out_targets.size();
+	unsigned int edges = 0;
+	for (size_t v = 0; v < table.size(); v++)
+		if (table[v] != nullptr) edges += ou_lists[v].size();
+	return edges;
+}
+unsigned int DMSGraph::in_degree(long id) const {
+	if (!has_vertex(id)) throw "Undefined vertex: ", id;
+	else if (frozen) return in_offsets[id + 1] - in_offsets[id];
+	else return in_lists[id].size();
+}
+unsigned int DMSGraph::out_degree(long id) const {
+	if (!has_vertex(id)) throw "Undefined vertex: ", id;
+	else if (frozen) return out_offsets[id + 1] - out_offsets[id];
+	else return ou_lists[id].size();
+}
+const std::list<DMSGSubsume> & DMSGraph::get_in_edges(long id) const {
+	if (frozen) throw "Invalid access: graph frozen";
+	else if (!has_vertex(id)) throw "Undefined vertex: ", id;
+	return in_lists[id];
+}
+const std::list<DMSGSubsume> & DMSGraph::get_out_edges(long id) const {
+	if (frozen) throw "Invalid access: graph frozen";
+	else if (!has_vertex(id)) throw "Undefined vertex: ", id;
+	return ou_lists[id];
+}
+DMSGNeighbors DMSGraph::get_sources(long id) const {
+	if (!frozen) throw "Invalid access: graph not frozen";
+	else if (!has_vertex(id)) throw "Undefined vertex: ", id;
+	const unsigned int * base = in_sources.data();
+	return DMSGNeighbors(base + in_offsets[id], base + in_offsets[id + 1]);
+}
+DMSGNeighbors DMSGraph::get_targets(long id) const {
+	if (!frozen) throw "Invalid access: graph not frozen";
+	else if (!has_vertex(id)) throw "Undefined vertex: ", id;
+	const unsigned int * base = out_targets.data();
+	return DMSGNeighbors(base + out_offsets[id], base + out_offsets[id + 1]);
+}
+void DMSGraph::update_roots() {
+	/* remove invalid roots (with ancestors) from this->roots */
+	auto beg = roots.begin(), end = roots.end();
 	while (beg != end) {
-		long vid = *(beg++);
-		roots.erase(vid);
+		if (!in_lists[*beg].empty())
+			beg = roots.erase(beg);
+		else beg++;
 	}
 
 	/* return */
 	return;
 }
 void DMSGraph::update_leafs() {
-	/* initialization */
-	remove_set.clear();
-
-	/* collect invalid root */
+	/* remove invalid leafs (with children) from this->leafs */
 	auto beg = leafs.begin(), end = leafs.end();
 	while (beg != end) {
-		long vid = *(beg++);
-		auto iter = vertices.find(vid);
-		DMSGVertex & vex = *(iter->second);
-		if (vex.out_degree() > 0)
-			remove_set.insert(vid);
-	}
-
-	/* remove invalid roots from this->roots */
-	beg = remove_set.begin(), end = remove_set.end();
-	while (beg != end) {
-		long vid = *(beg++);
-		leafs.erase(vid);
+		if (!ou_lists[*beg].empty())
+			beg = leafs.erase(beg);
+		else beg++;
 	}
 
 	/* return */
@@ -100,125 +220,357 @@ void DMSGraph::update_leafs() {
 }
 
 // DMSGVexIndex implement
-DMSGVexIndex::DMSGVexIndex() : mid_vex(), vid_vex() {}
+DMSGVexIndex::DMSGVexIndex() : mid_table(), mid_hash(), sparse(false), mnum(0), 
+	vid_vex(), vid_mutants(), vnum(0), indexed(false), mut_offsets(), mut_ids() {}
 DMSGVexIndex::~DMSGVexIndex() { this->clear(); }
 void DMSGVexIndex::add(DMSGVertex & node) {
 	long vid = node.get_id();
-	if (vid_vex.count(vid) == 0)
-		vid_vex[vid] = &node;
+	if (vid < 0) throw "Invalid vid: ", vid;
+	else if ((size_t)vid >= vid_vex.size()) {
+		vid_vex.resize(vid + 1, nullptr); vid_mutants.resize(vid + 1, 0);
+	}
+	if (vid_vex[vid] == nullptr) {
+		vid_vex[vid] = &node; vnum++;
+	}
+	indexed = false;
 }
 void DMSGVexIndex::add(long mid, DMSGVertex & node) {
+	add(node);
+	if (has_mutant(mid)) throw "Duplicated mutant: ", mid;
+
+	/* dense ids are kept in array, until a sparse one comes */
+	if (!sparse && (mid < 0 || (size_t)mid >= 4 * ((size_t)mnum + 16)))
+		to_sparse();
+	if (sparse) mid_hash[mid] = node.get_id();
+	else {
+		if ((size_t)mid >= mid_table.size()) 
+			mid_table.resize(mid + 1, -1L);
+		mid_table[mid] = node.get_id();
+	}
+	vid_mutants[node.get_id()]++; mnum++;
+}
+long DMSGVexIndex::remove(long mid) {
+	long vid = vertex_of_mutant(mid);
+	if (sparse) mid_hash.erase(mid);
+	else mid_table[mid] = -1L;
+	vid_mutants[vid]--; mnum--;
+	indexed = false;
+	return vid;
+}
+void DMSGVexIndex::remove(DMSGVertex & node) {
 	long vid = node.get_id();
-	if (vid_vex.count(vid) == 0)
-		vid_vex[vid] = &node;
-	if (mid_vex.count(mid) == 0) 
-		mid_vex[mid] = vid;
-	else throw "Duplicated mutant: ", mid;
+	if (!has_vertex(vid)) throw "Invalid vid: ", vid;
+	else if (vid_mutants[vid] > 0) throw "Invalid removal of vertex with mutants: ", vid;
+	vid_vex[vid] = nullptr; vnum--;
+	indexed = false;
+}
+void DMSGVexIndex::to_sparse() {
+	mid_hash.reserve(mnum);
+	for (size_t mid = 0; mid < mid_table.size(); mid++)
+		if (mid_table[mid] >= 0) mid_hash[mid] = mid_table[mid];
+	std::vector<long>().swap(mid_table);
+	sparse = true;
+}
+void DMSGVexIndex::index_mutants() {
+	/* ascending mutants, grouped by counting their vertices */
+	std::vector<long> mids; get_mutants(mids);
+	mut_offsets.assign(vid_vex.size() + 1, 0);
+	for (size_t k = 0; k < mids.size(); k++) 
+		mut_offsets[vertex_of_mutant(mids[k]) + 1]++;
+	for (size_t v = 0; v < vid_vex.size(); v++)
+		mut_offsets[v + 1] += mut_offsets[v];
+
+	std::vector<unsigned int> next(mut_offsets.begin(), mut_offsets.end() - 1);
+	mut_ids.resize(mids.size());
+	for (size_t k = 0; k < mids.size(); k++) 
+		mut_ids[next[vertex_of_mutant(mids[k])]++] = mids[k];
+	indexed = true;
+}
+void DMSGVexIndex::clear() { 
+	mid_table.clear(); mid_hash.clear(); sparse = false; mnum = 0;
+	vid_vex.clear(); vid_mutants.clear(); vnum = 0; 
+	indexed = false; mut_offsets.clear(); mut_ids.clear();
 }
-void DMSGVexIndex::clear() { mid_vex.clear(); vid_vex.clear(); }
 bool DMSGVexIndex::has_vertex(long vid) const {
-	return vid_vex.count(vid) > 0;
+	return vid >= 0 && (size_t)vid < vid_vex.size() && vid_vex[vid] != nullptr;
 }
 DMSGVertex & DMSGVexIndex::get_vertex(long vid) const {
-	if (vid_vex.count(vid) > 0) {
-		auto iter = vid_vex.find(vid);
-		return *(iter->second);
-	}
+	if (has_vertex(vid)) return *(vid_vex[vid]);
 	throw "Invalid vid: ", vid;
 }
 bool DMSGVexIndex::has_mutant(long mid) const {
-	return mid_vex.count(mid) > 0;
+	if (sparse) return mid_hash.count(mid) > 0;
+	else return mid >= 0 && (size_t)mid < mid_table.size() && mid_table[mid] >= 0;
 }
 long DMSGVexIndex::vertex_of_mutant(long mid) const {
-	if (mid_vex.count(mid) > 0) {
-		auto iter = mid_vex.find(mid);
-		return iter->second;
+	if (sparse) {
+		auto iter = mid_hash.find(mid);
+		if (iter != mid_hash.end()) return iter->second;
 	}
+	else if (has_mutant(mid)) return mid_table[mid];
 	throw "Invalid mid: ", mid;
 }
+DMSGSpan DMSGVexIndex::mutants_of(long vid) const {
+	if (!indexed) throw "Invalid access: mutants not indexed";
+	else if (!has_vertex(vid)) throw "Invalid vid: ", vid;
+	const long * base = mut_ids.data();
+	return DMSGSpan(base + mut_offsets[vid], base + mut_offsets[vid + 1]);
+}
+void DMSGVexIndex::get_mutants(std::vector<long> & mids) const {
+	mids.clear(); mids.reserve(mnum);
+	if (sparse) {
+		auto beg = mid_hash.begin(), end = mid_hash.end();
+		while (beg != end) mids.push_back((beg++)->first);
+		std::sort(mids.begin(), mids.end());
+	}
+	else {
+		for (size_t mid = 0; mid < mid_table.size(); mid++)
+			if (mid_table[mid] >= 0) mids.push_back(mid);
+	}
+}
 
 // DMSGHierarchy implement 
-DMSGHierarchy::DMSGHierarchy() : sort_list(), degree_map() {}
+DMSGHierarchy::DMSGHierarchy() : entries(), removed(), regraded(), sort_list(), level_of(), ids(), offsets(1, 0) {}
 DMSGHierarchy::~DMSGHierarchy() { clear(); }
 void DMSGHierarchy::add(const DMSGVertex & vec) {
-	BitSeq::size_t degree = vec.get_degree();
-
-	if (degree_map.count(degree) == 0) {
-		degree_map[degree] = new std::list<long>();
-		sort_list.push_back(degree);
+	entries.push_back(std::make_pair(vec.get_id(), vec.get_degree()));
+}
+void DMSGHierarchy::remove(const DMSGVertex & vec) {
+	long vid = vec.get_id();
+	if ((size_t)vid >= removed.size()) removed.resize(vid + 1, 0);
+	else if (removed[vid]) throw "Undefined vertex in hierarchy: ", vid;
+	removed[vid] = 1;
+}
+void DMSGHierarchy::regrade(const DMSGVertex & vec) {
+	regraded.push_back(std::make_pair(vec.get_id(), vec.get_degree()));
+}
+void DMSGHierarchy::compact() {
+	if (!regraded.empty()) {
+		/* the last degree of each vertex regraded (by its id) */
+		std::unordered_map<long, BitSeq::size_t> degrees;
+		for (size_t k = 0; k < regraded.size(); k++) degrees[regraded[k].first] = regraded[k].second;
+		for (size_t k = 0; k < entries.size(); k++) {
+			auto iter = degrees.find(entries[k].first);
+			if (iter != degrees.end()) entries[k].second = iter->second;
+		}
+		regraded.clear();
 	}
-
-	auto iter = degree_map.find(degree);
-	std::list<long> * list = iter->second;
-	list->push_front(vec.get_id());
+	if (removed.empty()) return;
+	size_t n = 0;
+	for (size_t k = 0; k < entries.size(); k++) {
+		long vid = entries[k].first;
+		if ((size_t)vid >= removed.size() || !removed[vid]) entries[n++] = entries[k];
+	}
+	entries.resize(n); removed.clear();
 }
 bool DMSGHierarchy::has_vertices(BitSeq::size_t degree) const {
-	return degree_map.count(degree) > 0;
+	return degree < level_of.size() && level_of[degree] >= 0;
 }
 unsigned int DMSGHierarchy::number_of_vertices(BitSeq::size_t degree) const {
-	if (degree_map.count(degree) == 0) return 0;
-	else {
-		auto iter = degree_map.find(degree);
-		std::list<long> * list = iter->second;
-		return list->size();
-	}
+	if (!has_vertices(degree)) return 0;
+	else return get_vertices_at(level_of[degree]).size();
 }
-const std::list<long> & DMSGHierarchy::get_vertices(BitSeq::size_t degree) const {
-	if (degree_map.count(degree) == 0)
+DMSGSpan DMSGHierarchy::get_vertices(BitSeq::size_t degree) const {
+	if (!has_vertices(degree))
 		throw "Undefined degree in hierarchy: ", degree;
-	else {
-		auto iter = degree_map.find(degree);
-		return *(iter->second);
-	}
+	else return get_vertices_at(level_of[degree]);
+}
+DMSGSpan DMSGHierarchy::get_vertices_in(BitSeq::size_t a, BitSeq::size_t b) const {
+	/* levels with degree in [a, b] are [lower, upper) */
+	auto lower = std::lower_bound(sort_list.begin(), sort_list.end(), a) - sort_list.begin();
+	auto upper = std::upper_bound(sort_list.begin(), sort_list.end(), b) - sort_list.begin();
+	if (a > b || lower >= upper) return DMSGSpan(ids.data(), ids.data());
+	else return DMSGSpan(ids.data() + offsets[upper], ids.data() + offsets[lower]);
 }
 void DMSGHierarchy::sort() {
-	std::sort(sort_list.begin(), sort_list.end());
+	/* count vertices of each degree */
+	BitSeq::size_t maximal = 0;
+	for (size_t k = 0; k < entries.size(); k++)
+		if (entries[k].second > maximal) maximal = entries[k].second;
+	std::vector<size_t> counts(entries.empty() ? 0 : maximal + 1, 0);
+	for (size_t k = 0; k < entries.size(); k++) counts[entries[k].second]++;
+
+	/* levels of degrees, and their bounds from the highest one */
+	sort_list.clear(); level_of.assign(counts.size(), -1);
+	for (size_t d = 0; d < counts.size(); d++) {
+		if (counts[d] == 0) continue;
+		level_of[d] = sort_list.size(); sort_list.push_back(d);
+	}
+	offsets.assign(sort_list.size() + 1, 0);
+	for (int i = (int)sort_list.size() - 1; i >= 0; i--)
+		offsets[i] = offsets[i + 1] + counts[sort_list[i]];
+
+	/* put vertices into their levels, the latest added first */
+	std::vector<size_t> next(sort_list.size());
+	for (size_t i = 0; i < sort_list.size(); i++) next[i] = offsets[i + 1];
+	ids.resize(entries.size());
+	for (size_t k = entries.size(); k > 0; k--) {
+		const std::pair<long, BitSeq::size_t> & entry = entries[k - 1];
+		ids[next[level_of[entry.second]]++] = entry.first;
+	}
 }
 void DMSGHierarchy::clear() {
-	auto beg = degree_map.begin(), end = degree_map.end();
-	while (beg != end) {
-		std::list<long> * list = (beg++)->second;
-		if (list != nullptr) {
-			list->clear(); delete list;
+	entries.clear(); removed.clear(); regraded.clear(); sort_list.clear(); level_of.clear();
+	ids.clear(); offsets.assign(1, 0);
+}
+DMSGSpan DMSGHierarchy::get_vertices_at(int i) const {
+	if (i < 0 || (size_t)i >= sort_list.size())
+		throw "Invalid index: ", i;
+	else return DMSGSpan(ids.data() + offsets[i + 1], ids.data() + offsets[i]);
+}
+
+// DMSGMatrix implement
+void DMSGMatrix::build(const DMSGHierarchy & hierarchy, const DMSGVexIndex & index) {
+	clear();
+
+	/* locate vertices level by level (degree descending) */
+	for (int i = hierarchy.number_of_levels() - 1; i >= 0; i--) {
+		DMSGSpan level = hierarchy.get_vertices_at(i);
+		size_t bound = order.size();
+		auto beg = level.begin(), end = level.end();
+		while (beg != end) {
+			long vid = *(beg++);
+			if ((size_t)vid >= locations.size()) {
+				locations.resize(vid + 1, 0); bounds.resize(vid + 1, 0);
+			}
+			locations[vid] = order.size(); bounds[vid] = bound;
+			order.push_back(vid);
+		}
+	}
+	if (order.empty()) return;
+
+	/* every vector must be dense and of the same words before any is moved */
+	size_t words = index.get_vertex(order[0]).get_vector().word_number();
+	for (size_t k = 0; k < order.size(); k++) {
+		long vid = order[k]; const BitSeq & vector = index.get_vertex(vid).get_vector();
+		if (vector.is_sparse() || vector.word_number() != words) {
+			clear(); throw "Invalid vector for matrix: ", vid;
 		}
 	}
-	sort_list.clear(); degree_map.clear();
+	if (words == 0) { clear(); return; }
+
+	/* move the vectors into rows */
+	stride = words;
+	rows = alloc_huge_words(order.size() * stride);
+	for (size_t k = 0; k < order.size(); k++)
+		index.get_vertex(order[k]).vector.borrow(rows + k * stride);
 }
-const std::list<long> & DMSGHierarchy::get_vertices_at(int i) const {
-	if (i < 0 || i > sort_list.size())
-		throw "Invalid index: ", i;
-	else {
-		BitSeq::size_t degree = sort_list[i];
-		auto iter = degree_map.find(degree);
-		return *(iter->second);
+void DMSGMatrix::clear() {
+	if (rows != nullptr) free_words(rows);
+	rows = nullptr; stride = 0;
+	order.clear(); locations.clear(); bounds.clear();
+}
+
+// DMSGTestColumns implement
+void DMSGTestColumns::build(const DMSGHierarchy & hierarchy, const DMSGVexIndex & index) {
+	clear();
+
+	/* locate vertices level by level (degree descending) */
+	for (int i = hierarchy.number_of_levels() - 1; i >= 0; i--) {
+		DMSGSpan level = hierarchy.get_vertices_at(i);
+		size_t bound = order.size();
+		auto beg = level.begin(), end = level.end();
+		while (beg != end) {
+			long vid = *(beg++);
+			if ((size_t)vid >= bounds.size()) bounds.resize(vid + 1, 0);
+			bounds[vid] = bound; order.push_back(vid);
+		}
+	}
+	if (order.empty()) return;
+
+	/* set the bit of vertex in the column of each test killing it */
+	tests = index.get_vertex(order[0]).get_vector().bit_number();
+	stride = (order.size() + WORD_BITS - 1) / WORD_BITS;
+	stride = (stride + VECTOR_WORDS - 1) / VECTOR_WORDS * VECTOR_WORDS;
+	columns = alloc_words((size_t)tests * stride);
+	std::fill(columns, columns + (size_t)tests * stride, 0ULL);
+	for (size_t k = 0; k < order.size(); k++) {
+		const BitSeq & vector = index.get_vertex(order[k]).get_vector();
+		word * column = columns + k / WORD_BITS; word bit = 1ULL << (k % WORD_BITS);
+		if (vector.is_sparse()) {
+			const unsigned int * items = vector.get_positions(); size_t count = vector.count();
+			for (size_t i = 0; i < count; i++) column[(size_t)items[i] * stride] |= bit;
+		}
+		else {
+			/* scan the words of dense vectors (padding bits are 0) */
+			const word * words = vector.get_words(); size_t length = vector.word_number();
+			for (size_t w = 0; w < length; w++) {
+				for (word wd = words[w]; wd != 0; wd &= wd - 1)
+					column[(w * WORD_BITS + word_ctz(wd)) * stride] |= bit;
+			}
+		}
 	}
 }
-unsigned int DMSGHierarchy::number_of_vertices() const {
-	unsigned int sum = 0; 
-	auto beg = degree_map.begin(), end = degree_map.end();
-	while (beg != end) {
-		std::list<long> * list = (beg++)->second;
-		sum += list->size();
+void DMSGTestColumns::clear() {
+	if (columns != nullptr) free_words(columns);
+	columns = nullptr; tests = 0; stride = 0;
+	order.clear(); bounds.clear();
+}
+size_t DMSGTestColumns::subsumed_by(const DMSGVertex & x, word * row) const {
+	/* only the vertices before the level of x have larger degree */
+	return subsumed_by(x.get_vector(), bounds[x.get_id()], row);
+}
+size_t DMSGTestColumns::subsumed_by(const BitSeq & vector, size_t bound, word * row) const {
+	size_t words = (bound + WORD_BITS - 1) / WORD_BITS;
+	size_t padded = (words + VECTOR_WORDS - 1) / VECTOR_WORDS * VECTOR_WORDS;
+	if (words == 0) return 0;
+
+	/* AND the columns of tests killing x (all vertices if none) */
+	BitSeq::size_t n = vector.bit_number(), t = vector.first_bit();
+	if (t < n) {
+		std::copy(columns + (size_t)t * stride, columns + (size_t)t * stride + padded, row);
+		for (t = vector.next_bit(t); t < n; t = vector.next_bit(t))
+			bit_kernels->conjunct(row, columns + (size_t)t * stride, padded);
 	}
-	return sum;
+	else std::fill(row, row + padded, ~0ULL);
+
+	/* clear the vertices from bound on */
+	if (bound % WORD_BITS != 0) row[words - 1] &= (1ULL << (bound % WORD_BITS)) - 1;
+	std::fill(row + words, row + padded, 0ULL);
+	return words;
+}
+size_t DMSGTestColumns::subsuming(const BitSeq & vector, size_t first, word * row) const {
+	size_t n = order.size();
+	if (first >= n) return 0;
+	size_t words = (n + WORD_BITS - 1) / WORD_BITS;
+	size_t start = first / WORD_BITS / VECTOR_WORDS * VECTOR_WORDS;
+
+	/* OR the columns of tests not killing x, the others are killed by tests of x only */
+	std::fill(row, row + stride, 0ULL);
+	BitSeq::size_t s = vector.first_bit();
+	for (BitSeq::size_t t = 0; t < tests; t++) {
+		if (t == s) s = vector.next_bit(s);
+		else bit_kernels->disjunct(row + start, columns + (size_t)t * stride + start, stride - start);
+	}
+	for (size_t k = start; k < words; k++) row[k] = ~row[k];
+
+	/* clear the vertices before first and from the last on */
+	for (size_t k = start; k < first / WORD_BITS; k++) row[k] = 0ULL;
+	if (first % WORD_BITS != 0) row[first / WORD_BITS] &= ~((1ULL << (first % WORD_BITS)) - 1);
+	if (n % WORD_BITS != 0) row[words - 1] &= (1ULL << (n % WORD_BITS)) - 1;
+	return words;
 }
 
 // implement iterator for DMSG
 void DMSGIter_DownTop::roll_next() {
 	nextptr = nullptr; long id;
 	while (!qlist.empty() && nextptr == nullptr) {
-		id = qlist.front(); qlist.pop();
-		if (records.count(id) > 0) continue;
-		else records.insert(id);
+		id = qlist.pop();
+		if (!records.insert(id)) continue;
 
 		nextptr = &(graph.get_vertex(id));
 
-		const std::list<DMSGSubsume> & edges = nextptr->get_in_edges();
+		if (graph.is_frozen()) {
+			DMSGNeighbors sources = graph.get_sources(id);
+			for (auto beg = sources.begin(); beg != sources.end(); beg++)
+				if (!records.has(*beg)) qlist.push(*beg);
+			continue;
+		}
+		const std::list<DMSGSubsume> & edges = graph.get_in_edges(id);
 		auto beg = edges.begin(), end = edges.end();
 		while (beg != end) {
 			long sid = ((beg++)->get_source()).get_id();
-			if (records.count(sid) > 0 
-				|| !graph.has_vertex(sid))
+			if (!graph.has_vertex(sid) || records.has(sid))
 				continue;
 			else qlist.push(sid);
 		}
@@ -227,17 +579,22 @@ void DMSGIter_DownTop::roll_next() {
 void DMSGIter_TopDown::roll_next() {
 	nextptr = nullptr; long id;
 	while (!qlist.empty() && nextptr == nullptr) {
-		id = qlist.front(); qlist.pop();
-		if (records.count(id) > 0) continue;
-		else records.insert(id);
+		id = qlist.pop();
+		if (!records.insert(id)) continue;
 
 		nextptr = &(graph.get_vertex(id));
 
-		const std::list<DMSGSubsume> & edges = nextptr->get_out_edges();
+		if (graph.is_frozen()) {
+			DMSGNeighbors targets = graph.get_targets(id);
+			for (auto beg = targets.begin(); beg != targets.end(); beg++)
+				if (!records.has(*beg)) qlist.push(*beg);
+			continue;
+		}
+		const std::list<DMSGSubsume> & edges = graph.get_out_edges(id);
 		auto beg = edges.begin(), end = edges.end();
 		while (beg != end) {
 			long tid = ((beg++)->get_target()).get_id();
-			if (records.count(tid) > 0 || !graph.has_vertex(tid))
+			if (!graph.has_vertex(tid) || records.has(tid))
 				continue;
 			else qlist.push(tid);
 		}
@@ -245,16 +602,18 @@ void DMSGIter_TopDown::roll_next() {
 }
 void DMSGIter_Random::roll_next() {
 	nextptr = nullptr;
-	if (cursor != end) {
-		long id = (cursor++)->first;
-		nextptr = &graph.get_vertex(id);
-	}
+	const std::vector<DMSGVertex *> & table = graph.table;
+	while (nextptr == nullptr && cursor < table.size())
+		nextptr = table[cursor++];
 }
 
 // builder for DMSG
 DMSGraphBuilder::DMSGraphBuilder(DMSGVexIndex & index, DMSGraph & g, DMSGHierarchy & h)
-	: useid(0L), index_lib(index), graph(g), hierarchy(h), state(END), compares(0) {}
-DMSGraphBuilder::~DMSGraphBuilder() {}
+	: useid(0L), index_lib(index), graph(g), hierarchy(h), state(END), compares(0), filtered(0), compress(false),
+	threads(1), pipeline(false), scratches(), sampled(), sampled_DSs(), clusters(nullptr), inserted() {
+	std::fill(levels_by, levels_by + 4, 0);
+}
+DMSGraphBuilder::~DMSGraphBuilder() { if (clusters != nullptr) delete clusters; }
 bool DMSGraphBuilder::open() {
 	if (state != END)
 		throw "Invalid access: ", state;
@@ -264,11 +623,13 @@ bool DMSGraphBuilder::open() {
 		index_lib.clear();
 		graph.clear();
 		hierarchy.clear();
+		return true;
 	}
 }
 DMSGVertex * DMSGraphBuilder::add_node(const KillVector & vec) {
-	DMSGVertex & vertex = *(new DMSGVertex(
+	DMSGVertex & vertex = *(graph.new_vertex(
 		useid++, vec.get_vector(), vec.get_quantity()));
+	if (compress) vertex.vector.compact();
 	index_lib.add(vec.get_mutant_ID(), vertex);
 	hierarchy.add(vertex);
 	return &vertex;
@@ -282,123 +643,564 @@ bool DMSGraphBuilder::sort_nodes() {
 		throw "Invalid access: ", state;
 	else {
 		hierarchy.sort();
+		/* sparse vectors are kept in vertices */
+		if (!compress) graph.matrix.build(hierarchy, index_lib);
 		state = SRT;
 		return true;
 	}
 }
-bool DMSGraphBuilder::link_nodes(const char strategy) {
+bool DMSGraphBuilder::link_nodes(char strategy) {
 	// validation 
 	if (state != SRT)
 		throw "Invalid access: ", state;
 
+	/* scratch of each thread for all the vertices created */
+	if (strategy == Inverted || strategy == Reduction || strategy == Auto) columns.build(hierarchy, index_lib);
+	/* the reach rows of reduction take n * n bits */
+	if (strategy == Reduction && (size_t)hierarchy.number_of_vertices() * columns.row_words() > MaximumReachWords)
+		strategy = Inverted;
+	std::fill(levels_by, levels_by + 4, 0);
+	scratches.resize(threads);
+	for (size_t t = 0; t < scratches.size(); t++) {
+		scratches[t].resize(useid);
+		scratches[t].row.resize(columns.row_words());
+		scratches[t].mask.resize((graph.matrix.number_of_rows() + WORD_BITS - 1) / WORD_BITS);
+	}
+
 	/* link node from down to top */
 	int n = hierarchy.number_of_levels();
-	for (int i = n - 1; i >= 0; i--)
-		this->link_level(i, strategy);
+	if (strategy == Reduction)
+		this->link_reduction();
+	else if (strategy == Auto)
+		this->link_adaptive();
+	else if (pipeline && threads > 1) {
+		this->link_pipeline(strategy, 0, hierarchy.number_of_vertices());
+		this->order_in_edges(hierarchy.get_link_order());
+	}
+	else {
+		for (int i = n - 1; i >= 0; i--)
+			this->link_level(i, strategy);
+	}
+	if (strategy >= DownTop && strategy <= Inverted) levels_by[(int)strategy] = n;
 	
 	// final works to translate 
 	state = CMP;
 	return true;
 }
+bool DMSGraphBuilder::link_dominators() {
+	if (state != SRT)
+		throw "Invalid access: ", state;
+	scratches.resize(threads);
+
+	/* nodes from low degree to high, kept if no kept one (of lower degree) subsumes it */
+	std::vector<DMSGVertex *> roots;
+	const std::vector<BitSeq::size_t> & degrees = hierarchy.get_degrees();
+	for (int i = 0; i < hierarchy.number_of_levels(); i++) {
+		if (degrees[i] == 0) continue;
+		DMSGSpan level = hierarchy.get_vertices_at(i);
+		std::vector<char> dominated(level.size(), 0);
+		this->run_parallel(level.size(), [this, &level, &roots, &dominated](size_t k, Scratch & scratch) {
+			dominated[k] = this->is_dominated(index_lib.get_vertex(level[k]), roots, scratch);
+		});
+
+		/* nodes at the same level do not subsume each other */
+		for (size_t k = 0; k < level.size(); k++) {
+			if (dominated[k]) continue;
+			DMSGVertex & x = index_lib.get_vertex(level[k]);
+			roots.push_back(&x); graph.add(x);
+		}
+	}
+
+	state = CMP;
+	return true;
+}
+bool DMSGraphBuilder::is_dominated(const DMSGVertex & y, const std::vector<DMSGVertex *> & roots, Scratch & scratch) {
+	for (size_t k = 0; k < roots.size(); k++) {
+		const DMSGVertex & x = *(roots[k]);
+		if (!x.may_subsume(y)) { scratch.filtered++; continue; }
+
+		scratch.compares++;
+		if (x.get_vector().subsume(y.get_vector())) return true;
+	}
+	return false;
+}
 bool DMSGraphBuilder::close() {
-	if (state != CMP)
+	if (state != CMP && state != UPD)
 		throw "Invalid access: ", state;
 	else {
+		if (state == UPD) { hierarchy.compact(); hierarchy.sort(); }
+		if (clusters != nullptr) { delete clusters; clusters = nullptr; }
+		columns.clear(); inserted.clear();
+		index_lib.index_mutants();
 		state = END; return true;
 	}
 }
-DMSGIterator & DMSGraphBuilder::get_iterator(char strategy) {
-	switch (strategy) {
-	case DownTop:
-		return *(new DMSGIter_DownTop(graph));
-	case TopDown:
-		return *(new DMSGIter_TopDown(graph));
-	case Random:
-		return *(new DMSGIter_Random(graph));
-	default:
-		throw "Invalid strategy: ", strategy;
+bool DMSGraphBuilder::reopen() {
+	if (state != END)
+		throw "Invalid access: ", state;
+	else {
+		graph.thaw();
+		useid = index_lib.vid_vex.size();
+		if (graph.table.size() > (size_t)useid) useid = graph.table.size();
+		compares = 0; filtered = 0;
+		scratches.resize(1); scratches[0].resize(useid);
+		state = UPD; return true;
+	}
+}
+void DMSGraphBuilder::index_vertices() {
+	/* clusters of the vectors */
+	if (clusters != nullptr) delete clusters;
+	clusters = new BitHashTable();
+	for (size_t v = 0; v < graph.table.size(); v++)
+		if (graph.has_vertex(v)) clusters->insert_vector(graph.table[v]->vector)->set_data(graph.table[v]);
+
+	this->index_columns();
+}
+void DMSGraphBuilder::index_columns() {
+	hierarchy.compact(); hierarchy.sort();
+	columns.build(hierarchy, index_lib); inserted.clear();
+	scratches[0].row.resize(columns.row_words());
+}
+DMSGVertex * DMSGraphBuilder::insert_mutant(const KillVector & vec) {
+	if (state != UPD)
+		throw "Invalid access: ", state;
+	long mid = vec.get_mutant_ID();
+	if (index_lib.has_mutant(mid)) throw "Duplicated mutant: ", mid;
+	const BitSeq & bits = vec.get_vector(); 
+	BitSeq::size_t degree = vec.get_quantity(); word signature = bits.fold();
+
+	if (!graph.roots.empty() && graph.table[*(graph.roots.begin())]->vector.bit_number() != bits.bit_number())
+		throw "Invalid vector for graph: ", mid;
+
+	/* the node of the same vector (a hit is confirmed by one comparison of vectors) */
+	if (clusters == nullptr) this->index_vertices();
+	Scratch & scratch = scratches[0]; scratch.resize(useid + 1);
+	BitHashEntry * entry = clusters->insert_vector(bits);
+	if (entry->get_data() != nullptr) {
+		DMSGVertex & y = *((DMSGVertex *) entry->get_data());
+		index_lib.add(mid, y); compares++; return &y;
+	}
+
+	/* the nodes subsuming (above) and subsumed by (below) the vector: in the test columns of nodes with lower 
+	and higher degree (by hierarchy), and among the nodes inserted since the columns are built; as in Inverted, 
+	each node found in columns is counted as a comparison */
+	DMSGMarks & above = scratch.visited, & below = scratch.direct, & tagged = scratch.tagged;
+	std::vector<long> & ups = scratch.candidates, & downs = scratch.subsumed; word * row = scratch.row.data();
+	above.reset(); below.reset(); ups.clear(); downs.clear();
+	size_t higher = hierarchy.get_vertices_in(degree + 1, bits.bit_number()).size();
+	size_t lower = hierarchy.get_vertices_in(degree, bits.bit_number()).size();
+	for (int i = 0; i < 2; i++) {
+		size_t words = (i == 0) ? columns.subsuming(bits, lower, row) : columns.subsumed_by(bits, higher, row);
+		DMSGMarks & marks = (i == 0) ? above : below; std::vector<long> & list = (i == 0) ? ups : downs;
+		for (size_t k = 0; k < words; k++) {
+			word w = row[k];
+			while (w != 0) {
+				long yid = columns.vertex_at(k * WORD_BITS + word_ctz(w));
+				w &= w - 1; scratch.compares++;
+				if (graph.has_vertex(yid)) { marks.mark(yid); list.push_back(yid); }
+			}
+		}
+	}
+	for (size_t k = 0; k < inserted.size(); k++) {
+		if (!graph.has_vertex(inserted[k])) continue;
+		const DMSGVertex & y = *(graph.table[inserted[k]]);
+		if (y.degree < degree) {
+			if ((y.signature & ~signature) != 0) { scratch.filtered++; continue; }
+			scratch.compares++;
+			if (y.vector.subsume(bits)) { above.mark(y.vid); ups.push_back(y.vid); }
+		}
+		else if (y.degree > degree) {
+			if ((signature & ~y.signature) != 0) { scratch.filtered++; continue; }
+			scratch.compares++;
+			if (bits.subsume(y.vector)) { below.mark(y.vid); downs.push_back(y.vid); }
+		}
+	}
+	std::sort(ups.begin(), ups.end()); std::sort(downs.begin(), downs.end());
+	this->collect_counters();
+
+	/* direct ones: subsuming nodes with no edge to another above, and subsumed nodes with no edge from another 
+	below (found by the parents of those above and children of those below, as low nodes have many children) */
+	DMSGMarks & indirect = scratch.records; indirect.reset();
+	for (size_t k = 0; k < ups.size(); k++) {
+		const std::list<DMSGSubsume> & edges = graph.in_lists[ups[k]];
+		for (auto beg = edges.begin(); beg != edges.end(); beg++) indirect.mark(beg->get_source().get_id());
+	}
+	for (size_t k = 0; k < downs.size(); k++) {
+		const std::list<DMSGSubsume> & edges = graph.ou_lists[downs[k]];
+		for (auto beg = edges.begin(); beg != edges.end(); beg++) indirect.mark(beg->get_target().get_id());
+	}
+	std::vector<DMSGVertex *> parents, children; tagged.reset();
+	for (size_t k = 0; k < ups.size(); k++)
+		if (!indirect.has(ups[k])) { parents.push_back(graph.table[ups[k]]); tagged.mark(ups[k]); }
+	for (size_t k = 0; k < downs.size(); k++)
+		if (!indirect.has(downs[k])) children.push_back(graph.table[downs[k]]);
+
+	/* create the node, and put it between its parents and children (instead of the edges from the ones to the others) */
+	DMSGVertex & x = *(graph.new_vertex(useid++, bits, degree));
+	if (compress) x.vector.compact();
+	index_lib.add(mid, x); hierarchy.add(x); graph.add(x); inserted.push_back(x.vid);
+	/* each list is passed once, as a parent (like the root) may have a long list of children */
+	indirect.reset(); above.reset();
+	for (size_t k = 0; k < children.size(); k++) {
+		std::list<DMSGSubsume> & edges = graph.in_lists[children[k]->vid];
+		for (auto beg = edges.begin(); beg != edges.end(); ) {
+			long pid = beg->get_source().get_id();
+			if (!tagged.has(pid)) { beg++; continue; }
+			above.mark(pid); indirect.mark(children[k]->vid); beg = edges.erase(beg);
+		}
+	}
+	for (size_t k = 0; k < parents.size(); k++) {
+		if (!above.has(parents[k]->vid)) continue;
+		std::list<DMSGSubsume> & edges = graph.ou_lists[parents[k]->vid];
+		for (auto beg = edges.begin(); beg != edges.end(); ) {
+			if (indirect.has(beg->get_target().get_id())) beg = edges.erase(beg);
+			else beg++;
+		}
+	}
+	for (size_t k = 0; k < parents.size(); k++) {
+		graph.link(*(parents[k]), x); graph.update_ends(*(parents[k]));
+	}
+	for (size_t k = 0; k < children.size(); k++) {
+		graph.link(x, *(children[k])); graph.update_ends(*(children[k]));
+	}
+	graph.update_ends(x); entry->set_data(&x);
+	if (inserted.size() > MaximumInsertedScan) this->index_columns();
+
+	/* return */ return &x;
+}
+void DMSGraphBuilder::remove_mutant(long mid) {
+	if (state != UPD)
+		throw "Invalid access: ", state;
+	long vid = index_lib.remove(mid);
+	if (index_lib.number_of_mutants(vid) > 0) return;
+
+	/* the node is left without mutants: link its parents to its children directly */
+	DMSGVertex & x = index_lib.get_vertex(vid);
+	if (graph.has_vertex(vid)) {
+		std::vector<DMSGVertex *> parents, children;
+		const std::list<DMSGSubsume> & ins = graph.in_lists[vid], & outs = graph.ou_lists[vid];
+		for (auto beg = ins.begin(); beg != ins.end(); beg++) parents.push_back(&(beg->get_source()));
+		for (auto beg = outs.begin(); beg != outs.end(); beg++) children.push_back(&(beg->get_target()));
+		for (size_t k = 0; k < parents.size(); k++) graph.unlink(*(parents[k]), x);
+		for (size_t k = 0; k < children.size(); k++) graph.unlink(x, *(children[k]));
+
+		/* a parent is linked to a child unless the child is reached from the parent by the other edges: search
+		the descendants of each parent once, only through the nodes subsuming some of the children */
+		Scratch & scratch = scratches[0]; scratch.resize(useid);
+		DMSGMarks & tagged = scratch.tagged; DMSGQueue & queue = scratch.queue;
+		BitSeq::size_t ceiling = 0;
+		for (size_t j = 0; j < children.size(); j++) 
+			if (children[j]->degree > ceiling) ceiling = children[j]->degree;
+		for (size_t k = 0; k < parents.size(); k++) {
+			const DMSGVertex & p = *(parents[k]);
+			tagged.reset(); queue.clear(); queue.push(p.vid);
+			while (!queue.empty()) {
+				const std::list<DMSGSubsume> & edges = graph.ou_lists[queue.pop()];
+				for (auto beg = edges.begin(); beg != edges.end(); beg++) {
+					const DMSGVertex & z = beg->get_target();
+					if (z.degree > ceiling || !tagged.insert(z.vid)) continue;
+					bool inside = false;
+					for (size_t j = 0; j < children.size() && !inside; j++) {
+						const DMSGVertex & c = *(children[j]);
+						if (&z == &c) inside = true;
+						else if (z.degree >= c.degree) continue;
+						else if (!z.may_subsume(c)) scratch.filtered++;
+						else { scratch.compares++; inside = z.vector.subsume(c.vector); }
+					}
+					if (inside) queue.push(z.vid);
+				}
+			}
+			for (size_t j = 0; j < children.size(); j++)
+				if (!tagged.has(children[j]->vid)) graph.link(*(parents[k]), *(children[j]));
+		}
+		this->collect_counters();
+		for (size_t k = 0; k < parents.size(); k++) graph.update_ends(*(parents[k]));
+		for (size_t k = 0; k < children.size(); k++) graph.update_ends(*(children[k]));
+		graph.remove(x);
+	}
+	if (clusters != nullptr) {
+		BitHashEntry * entry = clusters->get_entry(x.vector);
+		if (entry != nullptr) entry->set_data(nullptr);
 	}
+	index_lib.remove(x); hierarchy.remove(x);
 }
+void DMSGraphBuilder::append_tests(BitSeq::size_t testnum, 
+	const std::unordered_map<long, std::vector<BitSeq::size_t> > & appended) {
+	if (state != UPD)
+		throw "Invalid access: ", state;
+	BitSeq::size_t oldnum = 0;
+	for (size_t v = 0; v < graph.table.size() && oldnum == 0; v++)
+		if (graph.has_vertex(v)) oldnum = graph.table[v]->vector.bit_number();
+	if (testnum <= oldnum) throw "Invalid number of tests: ", testnum;
+
+	/* nodes of the mutants killed by appended tests (grouped by nodes) */
+	std::vector<std::pair<long, long> > owners;
+	for (auto iter = appended.begin(); iter != appended.end(); iter++) {
+		long mid = iter->first; const std::vector<BitSeq::size_t> & tests = iter->second;
+		if (!index_lib.has_mutant(mid)) throw "Undefined mutant: ", mid;
+		for (size_t k = 0; k < tests.size(); k++) {
+			if (tests[k] < oldnum || tests[k] >= testnum || (k > 0 && tests[k] <= tests[k - 1]))
+				throw "Invalid appended tests of mutant: ", mid;
+		}
+		if (!tests.empty()) owners.push_back(std::make_pair(index_lib.vertex_of_mutant(mid), mid));
+	}
+	std::sort(owners.begin(), owners.end());
+
+	/* extend the vectors of all nodes (the rows of matrix are left) */
+	for (size_t v = 0; v < graph.table.size(); v++) {
+		if (!graph.has_vertex(v)) continue;
+		DMSGVertex & x = *(graph.table[v]); const BitSeq & old = x.vector; BitSeq bits(testnum);
+		if (old.is_sparse()) bits.set_positions(old.get_positions(), old.count());
+		else bits.set_words(old.get_words(), (oldnum + WORD_BITS - 1) / WORD_BITS);
+		if (compress) bits.compact();
+		x.vector.unborrow(); x.vector = std::move(bits);
+	}
+	graph.matrix.clear();
+	if (clusters != nullptr) { delete clusters; clusters = nullptr; }
+	columns.clear(); inserted.clear();
+
+	/* split the nodes by the appended tests killing their mutants: a node keeps the mutants killed by none of 
+	them (or else the first group, and it is changed), and the other groups are moved into new nodes (splits) */
+	Scratch & scratch = scratches[0]; scratch.resize(useid);
+	DMSGMarks & changed = scratch.records; changed.reset();
+	std::unordered_map<long, std::vector<DMSGVertex *> > pieces; std::vector<DMSGVertex *> splits, bases;
+	std::vector<const std::vector<BitSeq::size_t> *> tests_of;
+	for (size_t k = 0, e = 0; k < owners.size(); k = e) {
+		long v = owners[k].first; DMSGVertex & x = *(graph.table[v]);
+		std::map<std::vector<BitSeq::size_t>, std::vector<long> > groups;
+		for (e = k; e < owners.size() && owners[e].first == v; e++) 
+			groups[appended.at(owners[e].second)].push_back(owners[e].second);
+
+		BitSeq base(x.vector); BitSeq::size_t degree = x.degree;
+		std::vector<DMSGVertex *> & list = pieces[v]; list.push_back(&x);
+		auto group = groups.begin();
+		if (index_lib.number_of_mutants(v) > e - k) bases.push_back(&x);
+		else {
+			const std::vector<BitSeq::size_t> & tests = appended.at(group->second[0]);
+			for (size_t j = 0; j < tests.size(); j++) x.vector.set_bit(tests[j], 1);
+			if (compress) x.vector.compact();
+			x.degree = degree + tests.size(); x.signature = x.vector.fold();
+			hierarchy.regrade(x); changed.mark(v);
+			splits.push_back(&x); tests_of.push_back(&tests); group++;
+		}
+		for (; group != groups.end(); group++) {
+			BitSeq bits(base); const std::vector<BitSeq::size_t> & tests = appended.at(group->second[0]);
+			for (size_t j = 0; j < tests.size(); j++) bits.set_bit(tests[j], 1);
+			if (compress) bits.compact();
+
+			DMSGVertex * y = graph.new_vertex(useid++, bits, degree + tests.size());
+			graph.add(*y); hierarchy.add(*y); list.push_back(y);
+			splits.push_back(y); tests_of.push_back(&tests);
+			const std::vector<long> & moved = group->second;
+			for (size_t j = 0; j < moved.size(); j++) {
+				index_lib.remove(moved[j]); index_lib.add(moved[j], *y);
+			}
+		}
+	}
+	scratch.resize(useid);
+
+	/* the direct ones among candidates (by degree ascending): subsumed by none of the nodes kept or accepted */
+	std::vector<std::pair<DMSGVertex *, DMSGVertex *> > links;
+	std::vector<DMSGVertex *> candidates, accepted;
+	auto accept = [this, &candidates, &accepted, &links](DMSGVertex & x) {
+		std::stable_sort(candidates.begin(), candidates.end(), [](const DMSGVertex * a, const DMSGVertex * b) {
+			return a->degree < b->degree;
+		});
+		for (size_t k = 0; k < candidates.size(); k++) {
+			const DMSGVertex & y = *(candidates[k]); bool direct = true;
+			for (size_t j = 0; j < accepted.size() && direct; j++) {
+				const DMSGVertex & z = *(accepted[j]);
+				if (z.degree >= y.degree) continue;
+				else if (!z.may_subsume(y)) { filtered++; continue; }
+				compares++; direct = !z.vector.subsume(y.vector);
+			}
+			if (direct) { accepted.push_back(candidates[k]); links.push_back(std::make_pair(&x, candidates[k])); }
+		}
+	};
 
-static std::queue<long> _node_queue;
-static std::set<long> _node_records;
-void DMSGraphBuilder::tag_ancestors(const DMSGVertex & x, std::set<long> & idset) {
-	/* clear the queue for search */
-	while (!_node_queue.empty())
-		_node_queue.pop();
-	_node_records.clear();
+	/* a split is subsumed by splits only, which have all of its appended tests (by the splits of each test) */
+	std::unordered_map<BitSeq::size_t, std::vector<DMSGVertex *> > holders;
+	for (size_t k = 0; k < splits.size(); k++) {
+		const std::vector<BitSeq::size_t> & tests = *(tests_of[k]);
+		for (size_t j = 0; j < tests.size(); j++) holders[tests[j]].push_back(splits[k]);
+	}
+	for (size_t k = 0; k < splits.size(); k++) {
+		DMSGVertex & x = *(splits[k]); const std::vector<BitSeq::size_t> & tests = *(tests_of[k]);
+		const std::vector<DMSGVertex *> * holder = &(holders[tests[0]]);
+		for (size_t j = 1; j < tests.size(); j++)
+			if (holders[tests[j]].size() < holder->size()) holder = &(holders[tests[j]]);
+
+		candidates.clear(); accepted.clear();
+		for (size_t j = 0; j < holder->size(); j++) {
+			DMSGVertex & y = *((*holder)[j]);
+			if (y.degree <= x.degree) continue;
+			else if (!x.may_subsume(y)) { filtered++; continue; }
+			compares++;
+			if (x.vector.subsume(y.vector)) candidates.push_back(&y);
+		}
+		accept(x);
+	}
 
-	/* put x into the queue */
-	_node_queue.push(x.get_id());
+	/* the nodes kept (without appended tests) above the split ones: the nodes split and the parents of changed 
+	ones, whose new children are their own splits and the nodes below changed children (searched through the 
+	changed nodes only), unless subsumed by their other children (kept) */
+	DMSGMarks & parented = scratch.direct, & visited = scratch.visited; DMSGQueue & queue = scratch.queue;
+	parented.reset(); std::vector<DMSGVertex *> parents;
+	for (size_t k = 0; k < bases.size(); k++) { parented.mark(bases[k]->vid); parents.push_back(bases[k]); }
+	for (size_t k = 0; k < splits.size(); k++) {
+		if (!changed.has(splits[k]->vid)) continue;
+		const std::list<DMSGSubsume> & edges = graph.in_lists[splits[k]->vid];
+		for (auto beg = edges.begin(); beg != edges.end(); beg++) {
+			DMSGVertex & r = beg->get_source();
+			if (!changed.has(r.vid) && parented.insert(r.vid)) parents.push_back(&r);
+		}
+	}
+	for (size_t k = 0; k < parents.size(); k++) {
+		DMSGVertex & x = *(parents[k]);
+		candidates.clear(); accepted.clear(); visited.reset(); queue.clear();
+		auto own = pieces.find(x.vid);
+		if (own != pieces.end()) candidates.insert(candidates.end(), own->second.begin() + 1, own->second.end());
+		const std::list<DMSGSubsume> & edges = graph.ou_lists[x.vid];
+		for (auto beg = edges.begin(); beg != edges.end(); beg++) {
+			DMSGVertex & c = beg->get_target(); visited.mark(c.vid);
+			if (changed.has(c.vid)) queue.push(c.vid);
+			else accepted.push_back(&c);
+		}
+		while (!queue.empty()) {
+			long u = queue.pop(); const std::vector<DMSGVertex *> & list = pieces[u];
+			candidates.insert(candidates.end(), list.begin(), list.end());
+			const std::list<DMSGSubsume> & outs = graph.ou_lists[u];
+			for (auto beg = outs.begin(); beg != outs.end(); beg++) {
+				DMSGVertex & w = beg->get_target();
+				if (!visited.insert(w.vid)) continue;
+				else if (changed.has(w.vid)) queue.push(w.vid);
+				else candidates.push_back(&w);
+			}
+		}
+		accept(x);
+	}
 
-	/* iterate the nodes from leafs to roots */
-	while (!_node_queue.empty()) {
-		long nid = _node_queue.front();
-		_node_queue.pop(); 
-		
-		const DMSGVertex & vertex = graph.get_vertex(nid);
-		const std::list<DMSGSubsume> & edges = vertex.get_in_edges();
+	/* drop the edges from changed nodes and those to them, and link the direct ones */
+	std::vector<DMSGVertex *> ends;
+	auto drop = [this, &ends](std::list<DMSGSubsume> & outs, const DMSGMarks * targets) {
+		for (auto beg = outs.begin(); beg != outs.end(); ) {
+			DMSGVertex & y = beg->get_target();
+			if (targets != nullptr && !targets->has(y.vid)) { beg++; continue; }
+			std::list<DMSGSubsume> & ins = graph.in_lists[y.vid]; const DMSGVertex * x = &(beg->get_source());
+			for (auto iter = ins.begin(); iter != ins.end(); ) {
+				if (&(iter->get_source()) == x) iter = ins.erase(iter);
+				else iter++;
+			}
+			ends.push_back(&y); beg = outs.erase(beg);
+		}
+	};
+	for (size_t k = 0; k < splits.size(); k++)
+		if (changed.has(splits[k]->vid)) drop(graph.ou_lists[splits[k]->vid], nullptr);
+	for (size_t k = 0; k < parents.size(); k++) drop(graph.ou_lists[parents[k]->vid], &changed);
+	for (size_t k = 0; k < links.size(); k++) graph.link(*(links[k].first), *(links[k].second));
+
+	/* roots and leafs of the nodes relinked */
+	for (size_t k = 0; k < splits.size(); k++) graph.update_ends(*(splits[k]));
+	for (size_t k = 0; k < parents.size(); k++) graph.update_ends(*(parents[k]));
+	for (size_t k = 0; k < ends.size(); k++) graph.update_ends(*(ends[k]));
+	for (size_t k = 0; k < links.size(); k++) graph.update_ends(*(links[k].second));
+}
+void DMSGraphBuilder::Scratch::resize(size_t n) {
+	visited.resize(n); tagged.resize(n);
+	direct.resize(n); records.resize(n);
+	queue.reserve(n); iter_queue.reserve(n);
+}
+void DMSGraphBuilder::tag_ancestors(const DMSGVertex & x, Scratch & scratch) {
+	/* put x into the queue for search */
+	DMSGQueue & queue = scratch.queue;
+	DMSGMarks & visited = scratch.visited;
+	queue.clear(); queue.push(x.get_id());
+
+	/* iterate the nodes from leafs to roots (stop at the visited ones) */
+	while (!queue.empty()) {
+		const std::list<DMSGSubsume> & edges = graph.in_lists[queue.pop()];
 		auto beg = edges.begin(), end = edges.end();
 		while (beg != end) {
 			const DMSGSubsume & edge = *(beg++);
 			long sid = edge.get_source().get_id();
 
-			if (_node_records.count(sid) > 0 
-				|| !graph.has_vertex(sid)
-				|| idset.count(sid) > 0)
+			if (!graph.has_vertex(sid) || !visited.insert(sid))
 				continue;
-			else {
-				idset.insert(sid); 
-				_node_records.insert(sid);
-				_node_queue.push(sid);
-			}
+			else queue.push(sid);
 		}
 	}
 
 	/* return */ return;
 }
-void DMSGraphBuilder::tag_descendants(const DMSGVertex & x, std::set<long> &idset) {
-	/* clear the queue for search */
-	while (!_node_queue.empty())
-		_node_queue.pop();
-	_node_records.clear();
-
-	/* put x into the queue */
-	_node_queue.push(x.get_id());
-
-	/* iterate the nodes from leafs to roots */
-	while (!_node_queue.empty()) {
-		long nid = _node_queue.front();
-		_node_queue.pop();
-
-		const DMSGVertex & vertex = graph.get_vertex(nid);
-		const std::list<DMSGSubsume> & edges = vertex.get_out_edges();
+void DMSGraphBuilder::tag_descendants(const DMSGVertex & x, Scratch & scratch) {
+	/* put x into the queue for search */
+	DMSGQueue & queue = scratch.queue;
+	DMSGMarks & tagged = scratch.tagged;
+	queue.clear(); tagged.reset();
+	queue.push(x.get_id());
+
+	/* iterate the nodes from roots to leafs */
+	while (!queue.empty()) {
+		const std::list<DMSGSubsume> & edges = graph.ou_lists[queue.pop()];
 		auto beg = edges.begin(), end = edges.end();
 		while (beg != end) {
 			const DMSGSubsume & edge = *(beg++);
 			long tid = edge.get_target().get_id();
 
-			if (_node_records.count(tid) > 0 
-				|| !graph.has_vertex(tid)
-				|| idset.count(tid) > 0)
+			if (!graph.has_vertex(tid) || !tagged.insert(tid))
 				continue;
 			else {
-				idset.insert(tid); 
-				_node_records.insert(tid);
-				_node_queue.push(tid);
+				/* DS = DS - descendants; VS = VS + descendants; */
+				scratch.direct.unmark(tid);
+				scratch.visited.mark(tid);
+				queue.push(tid);
 			}
 		}
-
 	}
 
 	/* return */ return;
 }
-static std::set<long> visitSpace;
-static std::set<long> childSet;
-void DMSGraphBuilder::find_direct_subsumed(const DMSGVertex & x, std::set<long> & DS, char strategy) {
+void DMSGraphBuilder::find_direct_subsumed(const DMSGVertex & x, std::vector<long> & DS, char strategy, Scratch & scratch) {
+	if (strategy == Inverted) {
+		this->find_inverted_subsumed(x, DS, scratch);
+		return;
+	}
+
+	/* random visits are decided by scanning the rows before level of x at once */
+	const DMSGMatrix & matrix = graph.matrix;
+	bool scanned = (strategy == Random && matrix.is_built());
+	size_t bound = 0;
+	if (scanned) {
+		bound = matrix.bound_of(x.get_id());
+		matrix.subsume_rows(x.get_vector().get_words(), 0, bound, scratch.mask.data());
+	}
+
+	/* visit the nodes by iterator of strategy (on the stack, reusing marks and queue of scratch) */
+	switch (strategy) {
+	case DownTop: {
+		DMSGIter_DownTop iter(graph, scratch.records, scratch.iter_queue);
+		this->search_subsumed(x, DS, iter, scratch, scanned, bound);
+	} break;
+	case TopDown: {
+		DMSGIter_TopDown iter(graph, scratch.records, scratch.iter_queue);
+		this->search_subsumed(x, DS, iter, scratch, scanned, bound);
+	} break;
+	case Random: {
+		DMSGIter_Random iter(graph, scratch.records);
+		this->search_subsumed(x, DS, iter, scratch, scanned, bound);
+	} break;
+	default:
+		throw "Invalid strategy: ", strategy;
+	}
+}
+template<class Iter> void DMSGraphBuilder::search_subsumed(const DMSGVertex & x, 
+	std::vector<long> & DS, Iter & iter, Scratch & scratch, bool scanned, size_t bound) {
 	/* initialization */
-	DMSGIterator & iter = this->get_iterator(strategy);
-	visitSpace.clear(); DS.clear(); childSet.clear();
+	const DMSGMatrix & matrix = graph.matrix;
+	const word * mask = scratch.mask.data();
+	DMSGMarks & visited = scratch.visited, & direct = scratch.direct;
+	std::vector<long> & candidates = scratch.candidates;
+	visited.reset(); direct.reset(); candidates.clear(); DS.clear();
 
 	/* iterate each node in graph*/
 	const DMSGVertex * y; long yid; 
@@ -409,57 +1211,117 @@ void DMSGraphBuilder::find_direct_subsumed(const DMSGVertex & x, std::set<long>
 
 		/* record the node in visits */
 		yid = y->get_id();
-		if (visitSpace.count(yid) > 0) 
-			continue;
-		else visitSpace.insert(yid);
-
-		/* count for the comparisons */ compares++; //cmps++;
+		if (!visited.insert(yid)) continue;
+
+		/* count for the comparisons (rejected by signatures, or by vectors); a scanned node is 
+		counted once its bit in the mask is read, as the rows not visited are not needed */
+		bool subsumed;
+		if ((subsumed = x.may_subsume(*y))) {
+			scratch.compares++;
+			if (scanned) {
+				size_t k = matrix.location_of(yid);
+				subsumed = k < bound && ((mask[k / WORD_BITS] >> (k % WORD_BITS)) & 1ULL) != 0;
+			}
+			else subsumed = x.get_vector().subsume(y->get_vector());
+		}
+		else scratch.filtered++;
 
 		/* if x subsumes y, then remove its descendants from visitSpace and DS */
-		if (x.get_vector().subsume(y->get_vector())) {
-			/* get the descendants for y */
-			childSet.clear(); 
-			this->tag_descendants(*y, childSet);
-			
-
-			/* DS = DS - descendants; VS = VS + descendants; */
-			auto beg = childSet.begin(), end = childSet.end();
-			while (beg != end) {
-				long cid = *(beg++);
-				DS.erase(cid);
-				visitSpace.insert(cid);
-			}
+		if (subsumed) {
+			this->tag_descendants(*y, scratch);
 
 			/* insert yid into DS temporarly */
-			DS.insert(yid);
+			direct.mark(yid); candidates.push_back(yid);
 		}
 		/* otherwise, remove its ancestors from visitSpace */
 		else {
-			this->tag_ancestors(*y, visitSpace);
+			this->tag_ancestors(*y, scratch);
 		}
 	} /* end while nodes in DMSG by now */
 
-	//std::cout << "{" << x.get_id() << "}: " << its << "\t" << cmps << "\t" << ts << "\t" << fs << "\tat: " << graph.number_of_vertices() << "/" << index_lib.number_of_vertices() << std::endl;
-	delete &iter;
+	/* the candidates left in DS, in ascending order */
+	auto beg = candidates.begin(), end = candidates.end();
+	while (beg != end) {
+		long cid = *(beg++);
+		if (direct.has(cid)) DS.push_back(cid);
+	}
+	std::sort(DS.begin(), DS.end());
+
 	/* return */ return;
 }
-void DMSGraphBuilder::link_level(int i, char strategy) {
-	/* initialization */
-	const std::list<long> & level = hierarchy.get_vertices_at(i);
-	auto beg = level.begin(), end = level.end();
-
-	/* link nodes at level to the nodes in current graph */
-	long xid; std::set<long> DS;
-	while (beg != end) {
-		/* get next node in level i */
-		xid = *(beg++);
-		DMSGVertex & x = index_lib.get_vertex(xid);
+void DMSGraphBuilder::find_inverted_subsumed(const DMSGVertex & x, std::vector<long> & DS, Scratch & scratch) {
+	/* the nodes subsumed by x: AND of the columns of tests killing x */
+	word * row = scratch.row.data();
+	size_t words = columns.subsumed_by(x, row);
+	DMSGMarks & tagged = scratch.tagged;
+	DMSGQueue & queue = scratch.queue;
+	tagged.reset(); DS.clear();
+
+	/* tag the descendants of each subsumed node (subsumed by x as well) */
+	for (size_t k = 0; k < words; k++) {
+		word bits = row[k];
+		while (bits != 0) {
+			long yid = columns.vertex_at(k * WORD_BITS + word_ctz(bits));
+			bits &= bits - 1;
+			scratch.compares++;
+			if (tagged.has(yid)) continue;
+
+			queue.clear(); queue.push(yid);
+			while (!queue.empty()) {
+				const std::list<DMSGSubsume> & edges = graph.ou_lists[queue.pop()];
+				auto beg = edges.begin(), end = edges.end();
+				while (beg != end) {
+					long tid = (beg++)->get_target().get_id();
+					if (graph.has_vertex(tid) && tagged.insert(tid))
+						queue.push(tid);
+				}
+			}
+		}
+	}
 
-		/* compute its direct subsumed nodes in DMSG */
-		find_direct_subsumed(x, DS, strategy);
+	/* the subsumed nodes that are not descendants of others */
+	for (size_t k = 0; k < words; k++) {
+		word bits = row[k];
+		while (bits != 0) {
+			long yid = columns.vertex_at(k * WORD_BITS + word_ctz(bits));
+			bits &= bits - 1;
+			if (!tagged.has(yid)) DS.push_back(yid);
+		}
+	}
+	std::sort(DS.begin(), DS.end());
 
-		/* link x to directly subsumed nodes in DMSG */
-		auto beg = DS.begin(), end = DS.end();
+	/* return */ return;
+}
+template<class Work> void DMSGraphBuilder::run_parallel(size_t n, Work work) {
+	unsigned int workers_number = threads;
+	if (workers_number > n / MinimumParallelVertices)
+		workers_number = n / MinimumParallelVertices;
+	if (workers_number <= 1) {
+		for (size_t k = 0; k < n; k++) work(k, scratches[0]);
+	}
+	else {
+		std::atomic<size_t> next(0);
+		run_threads(workers_number, [this, n, &work, &next](unsigned int t) {
+			size_t k;
+			while ((k = next++) < n) work(k, scratches[t]);
+		});
+	}
+	this->collect_counters();
+}
+void DMSGraphBuilder::link_level(int i, char strategy) {
+	/* initialization */
+	DMSGSpan xids = hierarchy.get_vertices_at(i);
+	std::vector<std::vector<long> > DSs(xids.size());
+
+	/* compute the direct subsumed nodes in DMSG for nodes at level (graph is not changed) */
+	this->run_parallel(xids.size(), [this, strategy, &xids, &DSs](size_t k, Scratch & scratch) {
+		this->find_or_reuse_subsumed(index_lib.get_vertex(xids[k]), DSs[k], strategy, scratch);
+	});
+
+	/* link nodes at level to their directly subsumed nodes in order */
+	for (size_t k = 0; k < xids.size(); k++) {
+		DMSGVertex & x = index_lib.get_vertex(xids[k]);
+		auto beg = DSs[k].begin(), end = DSs[k].end();
 		while (beg != end) {
 			DMSGVertex & y = index_lib.get_vertex(*(beg++));
 			graph.link(x, y);
@@ -467,20 +1329,385 @@ void DMSGraphBuilder::link_level(int i, char strategy) {
 	} /* end while link nodes */
 
 	/* put nodes into the graph */
-	beg = level.begin(), end = level.end();
-	while (beg != end) {
-		xid = *(beg++);
-		DMSGVertex & x = index_lib.get_vertex(xid);
-		graph.add(x);
-	}
+	for (size_t k = 0; k < xids.size(); k++)
+		graph.add(index_lib.get_vertex(xids[k]));
 
 	/* update the roots in DMSG */
 	graph.update_roots();
 
 	/* return */ return;
 }
+void DMSGraphBuilder::link_adaptive() {
+	/* the strategy is probed when graph is not empty, and again once it doubles */
+	char strategy = Random; size_t probed = 0, location = 0;
+	bool stealing = pipeline && threads > 1;
+	int i = hierarchy.number_of_levels() - 1;
+	while (i >= 0) {
+		size_t vnum = graph.number_of_vertices();
+		if (vnum > 0 && vnum >= 2 * probed) {
+			strategy = this->probe_strategy(i);
+			probed = vnum;
+		}
+
+		/* the levels up to the one where the graph doubles are linked by the strategy */
+		int j = i; size_t size = 0;
+		do size += hierarchy.get_vertices_at(j--).size();
+		while (j >= 0 && (vnum + size == 0 || vnum + size < 2 * probed));
+		levels_by[(int)strategy] += i - j;
+		if (stealing) this->link_pipeline(strategy, location, location + size);
+		else for (int k = i; k > j; k--) this->link_level(k, strategy);
+		location += size; i = j;
+	}
+	if (stealing) this->order_in_edges(hierarchy.get_link_order());
+	sampled.clear(); sampled_DSs.clear();
+}
+char DMSGraphBuilder::probe_strategy(int i) {
+	static const char strategies[] = { DownTop, TopDown, Random, Inverted };
+	DMSGSpan level = hierarchy.get_vertices_at(i);
+	size_t samples = (level.size() < AutoSampleVertices) ? level.size() : AutoSampleVertices;
+	Scratch & scratch = scratches[0];
+	sampled.resize(samples); sampled_DSs.resize(samples);
+	for (size_t k = 0; k < samples; k++) sampled[k] = level[k * level.size() / samples];
+
+	/* time (and comparisons) of each strategy on the vertices evenly sampled from level; only the counters 
+	of the chosen one are kept, as its results are reused to link the samples */
+	unsigned int compares = scratch.compares, filtered = scratch.filtered;
+	char best = Random; double best_time = 0; unsigned int best_compares = 0, best_filtered = 0;
+	std::vector<std::vector<long> > DSs(samples);
+	for (size_t s = 0; s < sizeof(strategies); s++) {
+		scratch.compares = 0; scratch.filtered = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (size_t k = 0; k < samples; k++)
+			this->find_direct_subsumed(index_lib.get_vertex(sampled[k]), DSs[k], strategies[s], scratch);
+		double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		if (s == 0 || time < best_time || (time == best_time && scratch.compares < best_compares)) {
+			best = strategies[s]; best_time = time;
+			best_compares = scratch.compares; best_filtered = scratch.filtered;
+			sampled_DSs.swap(DSs);
+		}
+	}
+	scratch.compares = compares + best_compares; scratch.filtered = filtered + best_filtered;
+	this->collect_counters();
+
+	/* return */ return best;
+}
+void DMSGraphBuilder::find_or_reuse_subsumed(const DMSGVertex & x, std::vector<long> & DS, char strategy, Scratch & scratch) {
+	for (size_t k = 0; k < sampled.size(); k++) {
+		if (sampled[k] == x.get_id()) { DS = sampled_DSs[k]; return; }
+	}
+	this->find_direct_subsumed(x, DS, strategy, scratch);
+}
+/* readers-writer lock on graph, preferring writers */
+class DMSGGraphLock {
+public:
+	DMSGGraphLock() : readers(0), writers(0), writing(false) {}
+
+	/* lock to read the graph (with other readers) */
+	void lock_shared() {
+		std::unique_lock<std::mutex> guard(mutex);
+		cond.wait(guard, [this]() { return !writing && writers == 0; });
+		readers++;
+	}
+	void unlock_shared() {
+		std::lock_guard<std::mutex> guard(mutex);
+		if (--readers == 0) cond.notify_all();
+	}
+	/* lock to change the graph (alone) */
+	void lock() {
+		std::unique_lock<std::mutex> guard(mutex);
+		writers++;
+		cond.wait(guard, [this]() { return !writing && readers == 0; });
+		writers--; writing = true;
+	}
+	void unlock() {
+		std::lock_guard<std::mutex> guard(mutex);
+		writing = false; cond.notify_all();
+	}
+
+private:
+	std::mutex mutex;
+	std::condition_variable cond;
+	unsigned int readers, writers;
+	bool writing;
+};
+/* 
+*	Schedule of pipelined link phase. Vertices are dispatched in the order of
+*	link_nodes (degree descending). A vertex is linked once no vertex out of graph
+*	subsumed by it is left: the ones not in graph before it with higher degree are
+*	compared to it (at most MaximumSupersetScan, otherwise the first of them blocks it).
+*	A blocked vertex waits on its blocker and is checked again once the blocker is
+*	linked. Ready vertices are put into the queue of the thread, and idle threads
+*	steal from the others.
+* */
+class DMSGLinkSchedule {
+public:
+	DMSGLinkSchedule(DMSGraphBuilder & b, const DMSGSpan & o, size_t first, unsigned int threads)
+		: builder(b), order(o), base(first), position(b.useid, 0), placed(b.useid), waiters(b.useid),
+		cursor(0), frontier(0), done(0), failed(false), queues(threads) {
+		for (size_t k = 0; k < order.size(); k++) position[order[k]] = k;
+		for (size_t k = 0; k < placed.size(); k++) placed[k] = false;
+	}
+
+	/* link vertices by the tth thread until all are linked */
+	void work(unsigned int t, char strategy) {
+		try {
+			long xid;
+			while (done < order.size() && !failed) {
+				if (this->pop(t, xid) || (this->dispatch(xid) && this->ready(xid)))
+					this->link(t, xid, strategy);
+				else std::this_thread::yield();
+			}
+		}
+		catch (...) { failed = true; throw; }
+	}
+
+private:
+	/* queue of ready vertices of a thread */
+	struct WorkQueue {
+		std::mutex mutex;
+		std::deque<long> items;
+	};
+
+	DMSGraphBuilder & builder;
+	/* vertex ids in the order of link_nodes (from the base location of it) */
+	DMSGSpan order; size_t base;
+	/* location of vertex in order */
+	std::vector<size_t> position;
+	/* whether vertex is linked and put in graph */
+	std::vector<std::atomic<bool> > placed;
+	/* vertices blocked by vertex */
+	std::vector<std::vector<long> > waiters;
+	/* next location to dispatch, and the first location not placed */
+	size_t cursor, frontier;
+	/* number of vertices linked */
+	std::atomic<size_t> done;
+	/* whether some thread fails */
+	std::atomic<bool> failed;
+	/* lock of waiters, cursor and frontier */
+	std::mutex mutex;
+	/* lock of graph */
+	DMSGGraphLock lock;
+	/* ready vertices of each thread */
+	std::vector<WorkQueue> queues;
+
+	/* take a vertex from the tail of own queue, or the head of the others */
+	bool pop(unsigned int t, long & xid) {
+		for (size_t k = 0; k < queues.size(); k++) {
+			WorkQueue & queue = queues[(t + k) % queues.size()];
+			std::lock_guard<std::mutex> guard(queue.mutex);
+			if (queue.items.empty()) continue;
+			else if (k == 0) { xid = queue.items.back(); queue.items.pop_back(); }
+			else { xid = queue.items.front(); queue.items.pop_front(); }
+			return true;
+		}
+		return false;
+	}
+	/* take the next vertex not dispatched */
+	bool dispatch(long & xid) {
+		std::lock_guard<std::mutex> guard(mutex);
+		if (cursor >= order.size()) return false;
+		xid = order[cursor++]; return true;
+	}
+	/* the vertex out of graph that may be subsumed by x (-1 if none) */
+	long blocker(long xid) {
+		size_t beg, end = position[xid];
+		{ std::lock_guard<std::mutex> guard(mutex); beg = frontier; }
+
+		const DMSGVertex & x = builder.index_lib.get_vertex(xid);
+		const DMSGMatrix & matrix = builder.graph.get_matrix();
+		long first = -1; size_t scans = 0; word mask = 0;
+		for (size_t k = beg; k < end; k++) {
+			/* rows (in the same order) are compared to x by 64 at once */
+			if (matrix.is_built() && (k - beg) % WORD_BITS == 0) {
+				size_t count = (end - k < WORD_BITS) ? end - k : WORD_BITS;
+				matrix.subsume_rows(x.get_vector().get_words(), base + k, count, &mask);
+			}
+
+			long yid = order[k];
+			if (placed[yid]) continue;
+			const DMSGVertex & y = builder.index_lib.get_vertex(yid);
+			if (y.get_degree() <= x.get_degree()) break;
+			else if (first < 0) first = yid;
+
+			if (++scans > DMSGraphBuilder::MaximumSupersetScan) return first;
+			else if (matrix.is_built() ? ((mask >> ((k - beg) % WORD_BITS)) & 1ULL) != 0
+				: x.may_subsume(y) && x.get_vector().subsume(y.get_vector())) return yid;
+		}
+		return -1;
+	}
+	/* whether x can be linked now, otherwise it waits on its blocker */
+	bool ready(long xid) {
+		while (true) {
+			long yid = this->blocker(xid);
+			if (yid < 0) return true;
+
+			std::lock_guard<std::mutex> guard(mutex);
+			if (!placed[yid]) {
+				waiters[yid].push_back(xid);
+				return false;
+			}
+		}
+	}
+	/* link x to the graph, and release the vertices waiting on it */
+	void link(unsigned int t, long xid, char strategy) {
+		DMSGraphBuilder::Scratch & scratch = builder.scratches[t];
+		DMSGVertex & x = builder.index_lib.get_vertex(xid);
+		std::vector<long> & DS = scratch.subsumed;
+
+		/* compute its direct subsumed nodes in graph */
+		lock.lock_shared();
+		try { builder.find_or_reuse_subsumed(x, DS, strategy, scratch); }
+		catch (...) { lock.unlock_shared(); throw; }
+		lock.unlock_shared();
+
+		/* link x to them and put it into graph */
+		lock.lock();
+		try { builder.commit_vertex(x, DS); }
+		catch (...) { lock.unlock(); throw; }
+		lock.unlock();
+
+		/* release the waiters of x */
+		std::vector<long> released;
+		{
+			std::lock_guard<std::mutex> guard(mutex);
+			placed[xid] = true;
+			while (frontier < order.size() && placed[order[frontier]]) frontier++;
+			released.swap(waiters[xid]);
+		}
+		done++;
+		for (size_t k = 0; k < released.size(); k++) {
+			if (this->ready(released[k])) {
+				std::lock_guard<std::mutex> guard(queues[t].mutex);
+				queues[t].items.push_back(released[k]);
+			}
+		}
+	}
+};
+void DMSGraphBuilder::link_pipeline(char strategy, size_t first, size_t last) {
+	/* vertices in the order of linking level by level */
+	DMSGSpan order = hierarchy.get_link_order();
+	DMSGSpan window(order.begin() + first, order.begin() + last);
+
+	/* threads link vertices by the schedule */
+	DMSGLinkSchedule schedule(*this, window, first, threads);
+	run_threads(threads, [&schedule, strategy](unsigned int t) { schedule.work(t, strategy); });
+	this->collect_counters();
+}
+void DMSGraphBuilder::link_reduction() {
+	/* rows of nodes subsumed by each node (strictly), located in order of linking */
+	size_t n = hierarchy.number_of_vertices(), stride = columns.row_words();
+	DMSGSpan order = hierarchy.get_link_order();
+	word * reach = alloc_words(n * stride);
+	std::fill(reach, reach + n * stride, 0ULL);
+	std::vector<std::vector<long> > DSs(n);
+
+	/* compute the rows, and then reduce them to direct subsumed nodes, each row by one thread */
+	try {
+		this->run_parallel(n, [this, stride, reach, &order](size_t k, Scratch &) {
+			columns.subsumed_by(index_lib.get_vertex(order[k]), reach + k * stride);
+		});
+		this->run_parallel(n, [this, stride, reach, &DSs](size_t k, Scratch & scratch) {
+			this->reduce_row(reach, stride, k, DSs[k], scratch);
+		});
+	}
+	catch (...) { free_words(reach); throw; }
+	free_words(reach);
+
+	/* link nodes and put them into graph level by level */
+	size_t k = 0;
+	for (int i = hierarchy.number_of_levels() - 1; i >= 0; i--) {
+		size_t first = k, size = hierarchy.get_vertices_at(i).size();
+		for (k = first; k < first + size; k++) {
+			DMSGVertex & x = index_lib.get_vertex(order[k]);
+			for (size_t j = 0; j < DSs[k].size(); j++)
+				graph.link(x, index_lib.get_vertex(DSs[k][j]));
+		}
+		for (k = first; k < first + size; k++)
+			graph.add(index_lib.get_vertex(order[k]));
+		graph.update_roots();
+	}
+}
+void DMSGraphBuilder::reduce_row(const word * reach, size_t stride, size_t k, std::vector<long> & DS, Scratch & scratch) {
+	/* row of direct subsumed nodes (the reach of k without reach of others in it) */
+	std::vector<word> & row = scratch.row;
+	const word * source = reach + k * stride;
+	std::copy(source, source + stride, row.begin());
+
+	/* remove the reach of nodes from the lowest degree on: a node removed is in reach of a removed one */
+	for (size_t w = stride; w-- > 0;) {
+		word bits = row[w];
+		while (bits != 0) {
+			unsigned int b = WORD_BITS - 1 - word_clz(bits);
+			bits &= ~(1ULL << b);
+			size_t j = w * WORD_BITS + b;
+			if ((row[w] & (1ULL << b)) == 0) continue;
+
+			scratch.compares++;
+			const word * other = reach + j * stride;
+			size_t words = w + 1;
+			for (size_t v = 0; v < words; v++) row[v] &= ~other[v];
+			bits &= row[w];
+		}
+	}
+
+	/* direct subsumed nodes in ascending order */
+	DS.clear();
+	for (size_t w = 0; w < stride; w++) {
+		word bits = row[w];
+		while (bits != 0) {
+			DS.push_back(columns.vertex_at(w * WORD_BITS + word_ctz(bits)));
+			bits &= bits - 1;
+		}
+	}
+	std::sort(DS.begin(), DS.end());
+}
+void DMSGraphBuilder::commit_vertex(DMSGVertex & x, const std::vector<long> & DS) {
+	/* x has no ancestor in graph, as its supersets are linked before it */
+	for (size_t k = 0; k < DS.size(); k++) {
+		graph.link(x, index_lib.get_vertex(DS[k]));
+		graph.roots.erase(DS[k]);
+	}
+	graph.add(x);
+}
+void DMSGraphBuilder::collect_counters() {
+	for (size_t t = 0; t < scratches.size(); t++) {
+		compares += scratches[t].compares;
+		filtered += scratches[t].filtered;
+		scratches[t].compares = 0; scratches[t].filtered = 0;
+	}
+}
+void DMSGraphBuilder::order_in_edges(const DMSGSpan & order) {
+	for (size_t k = 0; k < order.size(); k++)
+		graph.in_lists[order[k]].clear();
+
+	/* input edges are put at front in order of sources, and their targets in ascending order */
+	for (size_t k = 0; k < order.size(); k++) {
+		const std::list<DMSGSubsume> & edges = graph.ou_lists[order[k]];
+		auto beg = edges.rbegin(), end = edges.rend();
+		while (beg != end) {
+			const DMSGSubsume & edge = *(beg++);
+			graph.in_lists[edge.get_target().get_id()].push_front(edge);
+		}
+	}
+}
 
 // writer for DMSG
+/* flag in the length of vector for sparse vectors in data file */
+static const BitSeq::size_t SPARSE_VECTOR = 0x80000000U;
+/* put the ids of targets of edges from vertex (frozen or not) into ids */
+static void targets_of(const DMSGraph & graph, long vid, std::vector<long> & ids) {
+	ids.clear();
+	if (graph.is_frozen()) {
+		DMSGNeighbors targets = graph.get_targets(vid);
+		ids.assign(targets.begin(), targets.end());
+	}
+	else {
+		const std::list<DMSGSubsume> & edges = graph.get_out_edges(vid);
+		auto beg = edges.begin(), end = edges.end();
+		while (beg != end) ids.push_back((beg++)->get_target().get_id());
+	}
+}
 void DMSGraphWriter::open(const std::string & path) {
 	close();
 	out.open(path, std::ios::binary);
@@ -504,8 +1731,8 @@ void DMSGraphWriter::write(const DMSGraph & graph, const DMSGVexIndex & index) {
 	endin_subsumes();
 
 	/* output indexlib */
-	begin_indexlib(index);
-	write_indexlib(index);
+	begin_indexlib(graph, index);
+	write_indexlib(graph, index);
 	endin_indexlib();
 
 	/* return */
@@ -516,10 +1743,10 @@ void DMSGraphWriter::begin_vertices(const DMSGraph & graph) {
 	out.write((char *)(&vnum), sizeof(unsigned int));
 }
 void DMSGraphWriter::write_vertices(const DMSGraph & graph) {
-	auto beg = graph.vertices.begin(), end = graph.vertices.end();
+	auto beg = graph.table.begin(), end = graph.table.end();
 	while (beg != end) {
 		/* get next vertex from DMSG */
-		DMSGVertex * nodeptr = (beg++)->second;
+		DMSGVertex * nodeptr = *(beg++);
 		if (nodeptr == nullptr) continue;
 
 		/* derive its basic information */
@@ -527,13 +1754,21 @@ void DMSGraphWriter::write_vertices(const DMSGraph & graph) {
 		BitSeq::size_t degree = nodeptr->get_degree();
 		const BitSeq & vector = nodeptr->get_vector();
 		BitSeq::size_t bitnum = vector.bit_number();
-		const byte * bytes = vector.get_bytes();
 
 		/* output elements in vertex */
 		out.write((char *)(&vid), sizeof(long));
 		out.write((char *)(&degree), sizeof(BitSeq::size_t));
-		out.write((char *)(&bitnum), sizeof(BitSeq::size_t));
-		out.write((char *)(bytes), sizeof(byte) * vector.byte_number());
+		if (vector.is_sparse()) {
+			/* sparse vector: flagged length, number of indexes, indexes */
+			BitSeq::size_t flagged = bitnum | SPARSE_VECTOR, number = vector.count();
+			out.write((char *)(&flagged), sizeof(BitSeq::size_t));
+			out.write((char *)(&number), sizeof(BitSeq::size_t));
+			out.write((char *)(vector.get_positions()), sizeof(unsigned int) * number);
+		}
+		else {
+			out.write((char *)(&bitnum), sizeof(BitSeq::size_t));
+			out.write((char *)(vector.get_bytes()), sizeof(byte) * vector.byte_number());
+		}
 	}
 }
 void DMSGraphWriter::endin_vertices() {
@@ -544,49 +1779,51 @@ void DMSGraphWriter::endin_vertices() {
 	out.write((char *)(&bitnum), sizeof(BitSeq::size_t));
 }
 void DMSGraphWriter::write_subsumes(const DMSGraph & graph) {
-	auto beg = graph.vertices.begin(), end = graph.vertices.end();
+	std::vector<long> targets;
+	auto beg = graph.table.begin(), end = graph.table.end();
 	while (beg != end) {
 		/* get next vertex from DMSG */
-		DMSGVertex * nodeptr = (beg++)->second;
+		DMSGVertex * nodeptr = *(beg++);
 		if (nodeptr == nullptr) continue;
-		else if (nodeptr->out_degree() == 0) continue;
 
-		/* get source id and output */
+		/* get output edges */
 		long sid = nodeptr->get_id();
-		unsigned int out_degree = nodeptr->out_degree();
+		targets_of(graph, sid, targets);
+		if (targets.empty()) continue;
+
+		/* get source id and output */
+		unsigned int out_degree = targets.size();
 		out.write((char *)(&sid), sizeof(long));
 		out.write((char *)(&out_degree), sizeof(unsigned int));
 
-		/* get output edges */
-		auto edges = nodeptr->get_out_edges();
-		auto beg = edges.begin(), end = edges.end();
 		/* write each edge into data file */
-		while (beg != end) {
-			const DMSGSubsume & edge = *(beg++);
-			const DMSGVertex & target = edge.get_target();
-			long tid = target.get_id();
-
+		for (size_t k = 0; k < targets.size(); k++) {
+			long tid = targets[k];
 			out.write((char *)(&tid), sizeof(long));
 		}
-
-		/* return */ return;
 	}
+
+	/* return */ return;
 }
 void DMSGraphWriter::endin_subsumes() {
 	long sid = -1; unsigned int out_degree = 0;
 	out.write((char *)(&sid), sizeof(long));
 	out.write((char *)(&out_degree), sizeof(unsigned int));
 }
-void DMSGraphWriter::begin_indexlib(const DMSGVexIndex & index) {
-	unsigned int mnum = index.number_of_mutants();
+void DMSGraphWriter::begin_indexlib(const DMSGraph & graph, const DMSGVexIndex & index) {
+	/* only mutants of the vertices in graph (all but in a graph of dominators) */
+	std::vector<long> mids; index.get_mutants(mids);
+	unsigned int mnum = 0;
+	for (size_t k = 0; k < mids.size(); k++)
+		if (graph.has_vertex(index.vertex_of_mutant(mids[k]))) mnum++;
 	out.write((char *)(&mnum), sizeof(unsigned int));
 }
-void DMSGraphWriter::write_indexlib(const DMSGVexIndex & index) {
-	auto beg = index.mid_vex.begin(), end = index.mid_vex.end();
-	while (beg != end) {
-		long mid = beg->first;
-		long vid = beg->second;
-		beg++;
+void DMSGraphWriter::write_indexlib(const DMSGraph & graph, const DMSGVexIndex & index) {
+	std::vector<long> mids; index.get_mutants(mids);
+	for (size_t k = 0; k < mids.size(); k++) {
+		long mid = mids[k];
+		long vid = index.vertex_of_mutant(mid);
+		if (!graph.has_vertex(vid)) continue;
 
 		out.write((char *)(&mid), sizeof(long));
 		out.write((char *)(&vid), sizeof(long));
@@ -616,19 +1853,21 @@ void DMSGraphReader::read(DMSGraph & graph, DMSGVexIndex & index, DMSGHierarchy
 	initial_graph(graph, index, hierarchy);
 
 	/* read vertices, subsumption and index */
-	read_vertices(index, hierarchy);
+	read_vertices(graph, index, hierarchy);
 	read_subsumes(index, graph);
 	read_indexlib(index);
+	hierarchy.sort();
 
 	/* reconstruct the graph */
 	rebuild_graph(index, graph);
+	index.index_mutants();
 }
 void DMSGraphReader::initial_graph(DMSGraph & graph, DMSGVexIndex & index, DMSGHierarchy & hierarchy) {
 	graph.clear();
 	index.clear();
 	hierarchy.clear();
 }
-void DMSGraphReader::read_vertices(DMSGVexIndex & index, DMSGHierarchy & hierarchy) {
+void DMSGraphReader::read_vertices(DMSGraph & graph, DMSGVexIndex & index, DMSGHierarchy & hierarchy) {
 	/* consume vertex number title */
 	unsigned int vnum;
 	in.read((char *)(&vnum), sizeof(unsigned int));
@@ -643,12 +1882,19 @@ void DMSGraphReader::read_vertices(DMSGVexIndex & index, DMSGHierarchy & hierarc
 		if (vid == -1L && degree == 0 && bitnum == 0)
 			throw "Data file errors!";
 
-		/* consume bytes for vector */
-		BitSeq vector(bitnum);
-		in.read((char *)(vector.get_bytes()), sizeof(byte) * vector.byte_number());
+		/* consume bytes (or indexes of sparse one) for vector */
+		BitSeq vector(bitnum & ~SPARSE_VECTOR);
+		if ((bitnum & SPARSE_VECTOR) != 0) {
+			BitSeq::size_t number;
+			in.read((char *)(&number), sizeof(BitSeq::size_t));
+			std::vector<unsigned int> positions(number);
+			in.read((char *)(positions.data()), sizeof(unsigned int) * number);
+			vector.set_positions(positions.data(), number);
+		}
+		else in.read((char *)(vector.get_bytes()), sizeof(byte) * vector.byte_number());
 
 		/* create vertex and put into index and hierarchy */
-		DMSGVertex * node = new DMSGVertex(vid, vector, degree);
+		DMSGVertex * node = graph.new_vertex(vid, vector, degree);
 		index.add(*node); hierarchy.add(*node);
 	}
 	/* consume tail of vertex */
@@ -700,8 +1946,8 @@ void DMSGraphReader::read_indexlib(DMSGVexIndex & index) {
 void DMSGraphReader::rebuild_graph(DMSGVexIndex & index, DMSGraph & graph) {
 	auto beg = index.vid_vex.begin(), end = index.vid_vex.end();
 	while (beg != end) {
-		DMSGVertex & node = *(beg->second);
-		graph.add(node);
+		DMSGVertex * node = *(beg++);
+		if (node != nullptr) graph.add(*node);
 	}
 }
 
@@ -730,17 +1976,16 @@ void printDMSG(const DMSGVexIndex & index, const DMSGraph & graph,
 	out << "\n";
 
 	out << "Edges: \n"; unsigned int edges = 0;
-	unsigned int vnum = graph.number_of_vertices();
-	for (long i = 0; i < vnum; i++) {
+	long bound = graph.id_bound();
+	std::vector<long> targets;
+	for (long i = 0; i < bound; i++) {
+		if (!graph.has_vertex(i)) continue;
 		const DMSGVertex & x = graph.get_vertex(i);
 		out << "\t" << x.get_id() << " --> ";
 
-		auto out_edges = x.get_out_edges();
-		auto beg = out_edges.begin(), end = out_edges.end();
-		while (beg != end) {
-			DMSGSubsume & edge = *(beg++);
-			DMSGVertex & target = edge.get_target();
-			out << target.get_id() << "; ";
+		targets_of(graph, i, targets);
+		for (size_t k = 0; k < targets.size(); k++) {
+			out << targets[k] << "; ";
 			edges++;
 		}
 		
@@ -771,13 +2016,7 @@ void efficiencyAnalysis(const DMSGVexIndex & index, const DMSGHierarchy & hierar
 
 	T3 = builder.get_comparisons();
 
-	T4 = 0;
-	unsigned int vnum = graph.number_of_vertices();
-	for (long i = 0; i < vnum; i++) {
-		const DMSGVertex & x = graph.get_vertex(i);
-		auto edges = x.get_out_edges();
-		T4 += edges.size();
-	}
+	T4 = graph.number_of_edges();
 
 	std::cout << "Number of edges: " << T4 << std::endl;
 
@@ -789,30 +2028,23 @@ void efficiencyAnalysis(const DMSGVexIndex & index, const DMSGHierarchy & hierar
 }
 void printDMSGString(const DMSGVexIndex & index, DMSGraph & graph, std::ostream & out) {
 	out << "Index-Map: \n";
-	long mid = 0, end = index.number_of_mutants();
-	while (mid++ < end) {
-		if (index.has_mutant(mid)) {
-			long vid = index.vertex_of_mutant(mid);
-			out << "\t" << mid << "\t" << vid << "\n";
-		}
-	}
+	std::vector<long> mids; index.get_mutants(mids);
+	for (size_t k = 0; k < mids.size(); k++)
+		out << "\t" << mids[k] << "\t" << index.vertex_of_mutant(mids[k]) << "\n";
 	out << "\n";
 
 	out << "Graph Map: \n";
-	long vnum = graph.number_of_vertices(), vid = 0;
-	while (vid < vnum) {
+	long bound = graph.id_bound();
+	std::vector<long> targets;
+	for (long vid = 0; vid < bound; vid++) {
+		if (!graph.has_vertex(vid)) continue;
 		const DMSGVertex & vertex = graph.get_vertex(vid);
 		out << vertex.get_id() << " : ";
 
-		const std::list<DMSGSubsume> & out_edges = vertex.get_out_edges();
-		auto beg = out_edges.begin(), end = out_edges.end();
-		while (beg != end) {
-			const DMSGSubsume & edge = *(beg++);
-			out << edge.get_target().get_id() << " ";
-		}
+		targets_of(graph, vid, targets);
+		for (size_t k = 0; k < targets.size(); k++)
+			out << targets[k] << " ";
 		out << "\n";
-
-		vid++;
 	}
 
 	out << std::endl;
@@ -19,18 +19,28 @@
 #include "bitseq.h"
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <vector>
 #include <queue>
 #include <fstream>
+#include <algorithm>
+#include <thread>
+#include <exception>
 
 /*---- core data structure ----*/
 class DMSGVertex;
 class DMSGSubsume;
+class DMSGMatrix;
+class DMSGNeighbors;
 class DMSGraph;
+class DMSGSpan;
 class DMSGVexIndex;
 /*---- algorithm data structure ----*/
+class DMSGMarks;
+class DMSGQueue;
+class DMSGTestColumns;
 class DMSGHierarchy;
-class DMSGIterator;
+template<class Iter> class DMSGIterator;
 	class DMSGIter_DownTop;
 	class DMSGIter_TopDown;
 	class DMSGIter_Random;
@@ -63,15 +73,13 @@ class DMSGVertex {
 protected:
 	/* vertex identity */
 	const long vid;
-	/* list of edge to this node */
-	std::list<DMSGSubsume> in_list;
-	/* list of edge from this node */
-	std::list<DMSGSubsume> ou_list;
 
 	/* score vector of this node (cluster) */
 	BitSeq vector;
 	/* degree of this node (cluster) */
 	BitSeq::size_t degree;
+	/* OR-fold of the vector, a bit-1 of x missing in y excludes that x subsumes y */
+	word signature;
 
 	/* create a distincted node by its id */
 	DMSGVertex(long, const BitSeq &, BitSeq::size_t);
@@ -80,37 +88,127 @@ protected:
 public:
 	/* get the id of this node */
 	long get_id() const { return vid; }
-	/* input degree */
-	unsigned int in_degree() const { return in_list.size(); }
-	/* output degree */
-	unsigned int out_degree() const { return ou_list.size(); }
-	/* get the input edges */
-	const std::list<DMSGSubsume> & get_in_edges() const { return in_list; }
-	/* get the output edges */
-	const std::list<DMSGSubsume> & get_out_edges() const { return ou_list; }
 	/* get score vector of this node */
 	const BitSeq & get_vector() const { return vector; }
 	/* get degree of this node vector */
 	BitSeq::size_t get_degree() const { return degree; }
+	/* get the OR-fold of the vector */
+	word get_signature() const { return signature; }
+	/* false if this node cannot subsume y, by their signatures and degrees only */
+	bool may_subsume(const DMSGVertex & y) const {
+		return (signature & ~y.signature) == 0 && degree <= y.degree;
+	}
 
 	friend class DMSGraphReader;	// create
 	friend class DMSGraphBuilder;	// create
 	friend class DMSGraph;			// delete
+	friend class DMSGMatrix;		// borrow vector
+};
+/*
+*	Kill-vectors of vertices in one block of rows (row-major). Rows are aligned to
+*	VECTOR_BYTES, the block is on huge pages when it is large, and rows are located
+*	in the order of linking (degree descending), so the vertices that x may subsume
+*	are the rows before its level. The vectors of vertices borrow their rows.
+* */
+class DMSGMatrix {
+protected:
+	/* vertex id of each row */
+	std::vector<long> order;
+	/* row of vertex (by id) */
+	std::vector<size_t> locations;
+	/* row of the first vertex at the level of vertex (by id) */
+	std::vector<size_t> bounds;
+	/* number of words in a row (padded to vector width) */
+	size_t stride;
+	/* block of rows */
+	word * rows;
+
+	/* move the (dense) vectors of vertices in sorted hierarchy into rows */
+	void build(const DMSGHierarchy &, const DMSGVexIndex &);
+	/* release the rows (after vertices borrowing them are deleted) */
+	void clear();
+public:
+	DMSGMatrix() : order(), locations(), bounds(), stride(0), rows(nullptr) {}
+	~DMSGMatrix() { clear(); }
+
+	/* whether vectors of vertices are kept in rows */
+	bool is_built() const { return rows != nullptr; }
+	/* number of rows */
+	size_t number_of_rows() const { return order.size(); }
+	/* number of words in a row */
+	size_t row_words() const { return stride; }
+	/* id of the vertex at kth row */
+	long vertex_at(size_t k) const { return order[k]; }
+	/* row of the vertex */
+	size_t location_of(long vid) const { return locations[vid]; }
+	/* number of rows before the level of vertex (the ones with higher degree) */
+	size_t bound_of(long vid) const { return bounds[vid]; }
+	/* words of kth row */
+	const word * row(size_t k) const { return rows + k * stride; }
+	/* bit r of result is whether x (words of a row) subsumes the row (first + r), for count rows */
+	void subsume_rows(const word * x, size_t first, size_t count, word * result) const {
+		bit_kernels->subsume_rows(x, rows + first * stride, stride, stride, count, result);
+	}
+
+	friend class DMSGraph;
+	friend class DMSGraphBuilder;
+};
+/* ids of neighbours of a vertex in frozen graph */
+class DMSGNeighbors {
+public:
+	DMSGNeighbors(const unsigned int * b, const unsigned int * e) : first(b), last(e) {}
+	const unsigned int * begin() const { return first; }
+	const unsigned int * end() const { return last; }
+	size_t size() const { return last - first; }
+private:
+	const unsigned int * first, * last;
 };
-/* mutant subsumption graph */
+/* 
+*	mutant subsumption graph. Vertices are allocated in an arena of the graph, and
+*	their edges are kept in lists of the graph by vertex id. Once built, freeze() moves
+*	the edges into CSR arrays (offsets of each vertex in arrays of 32-bit neighbour ids)
+*	and roots and leafs into sorted vectors, releasing the lists; a frozen graph can
+*	not be changed, and its edges are read by get_sources() and get_targets().
+* */
 class DMSGraph {
 protected:
-	/* set of roots (without ancestor) */
+	/* set of roots (without ancestor), moved into root_list by freeze() */
 	std::set<long> roots;
-	/* set of leafs (without children) */
+	/* set of leafs (without children), moved into leaf_list by freeze() */
 	std::set<long> leafs;
-	/* map from vertex id to their entity */
-	std::map<long, DMSGVertex *> vertices;
-
+	/* vertices indexed by their (dense) id, null for ids not in graph */
+	std::vector<DMSGVertex *> table;
+	/* number of vertices in graph */
+	unsigned int vnum;
+	/* rows of vectors of vertices (when built by builder) */
+	DMSGMatrix matrix;
+	/* vertices created in the arena */
+	std::vector<DMSGVertex *> created;
+	WordArena arena;
+	/* edges to and from each vertex (by id) until frozen, released by freeze() */
+	std::vector<std::list<DMSGSubsume> > in_lists, ou_lists;
+
+	/* whether edges are in CSR arrays */
+	bool frozen;
+	/* targets of vertex v in out_targets[out_offsets[v], out_offsets[v + 1]) */
+	std::vector<unsigned int> out_offsets, out_targets;
+	/* sources of vertex v in in_sources[in_offsets[v], in_offsets[v + 1]) */
+	std::vector<unsigned int> in_offsets, in_sources;
+	/* sorted ids of roots and leafs in frozen graph */
+	std::vector<long> root_list, leaf_list;
+
+	/* create a vertex in the arena (released by clear()) */
+	DMSGVertex * new_vertex(long, const BitSeq &, BitSeq::size_t);
 	/* add a (new) vertex into the graph */
 	void add(DMSGVertex &);
 	/* link two vertex together, this will update roots and leafs */
 	void link(DMSGVertex &, DMSGVertex &);
+	/* remove the edge between two vertices (if any) */
+	void unlink(DMSGVertex &, DMSGVertex &);
+	/* remove a vertex without edges from the graph (it is released by clear()) */
+	void remove(DMSGVertex &);
+	/* put the vertex in (or out of) roots and leafs by its edges */
+	void update_ends(const DMSGVertex &);
 	/* clear all the nodes and edges in the graph */
 	void clear();
 
@@ -124,34 +222,113 @@ public:
 	/* clear the nodes in graph */
 	~DMSGraph();
 
-	/* get roots (without ancestor) */
-	const std::set<long> & get_roots() const { return roots; }
-	/* get leafs (without children) */
-	const std::set<long> & get_leafs() const { return leafs; }
+	/* get roots (without ancestor) of graph not frozen (see get_root_list) */
+	const std::set<long> & get_roots() const {
+		if (frozen) throw "Invalid access: graph frozen";
+		return roots;
+	}
+	/* get leafs (without children) of graph not frozen (see get_leaf_list) */
+	const std::set<long> & get_leafs() const {
+		if (frozen) throw "Invalid access: graph frozen";
+		return leafs;
+	}
 	/* get the number of vertices in graph */
-	unsigned int number_of_vertices() const { return vertices.size(); }
+	unsigned int number_of_vertices() const { return vnum; }
+	/* get the number of edges in graph */
+	unsigned int number_of_edges() const;
+
+	/* move edges into CSR arrays, and roots and leafs into sorted vectors (vertex ids must be less than 2^32) */
+	void freeze();
+	/* move edges back into lists (in the same order), so the graph can be changed */
+	void thaw();
+	/* whether the graph is frozen */
+	bool is_frozen() const { return frozen; }
+	/* number of edges to the vertex */
+	unsigned int in_degree(long id) const;
+	/* number of edges from the vertex */
+	unsigned int out_degree(long id) const;
+	/* edges to the vertex (not frozen, see get_sources) */
+	const std::list<DMSGSubsume> & get_in_edges(long id) const;
+	/* edges from the vertex (not frozen, see get_targets) */
+	const std::list<DMSGSubsume> & get_out_edges(long id) const;
+	/* ids of sources of edges to the vertex (frozen only) */
+	DMSGNeighbors get_sources(long id) const;
+	/* ids of targets of edges from the vertex (frozen only) */
+	DMSGNeighbors get_targets(long id) const;
+	/* sorted ids of roots (frozen only) */
+	const std::vector<long> & get_root_list() const { return root_list; }
+	/* sorted ids of leafs (frozen only) */
+	const std::vector<long> & get_leaf_list() const { return leaf_list; }
+
+	/* bound of vertex ids (ids in [0, bound) without vertex are left by removals) */
+	long id_bound() const { return table.size(); }
 	/* whether there is vertex referred by id */
-	bool has_vertex(long id) const;
+	bool has_vertex(long id) const {
+		return id >= 0 && (size_t)id < table.size() && table[id] != nullptr;
+	}
 	/* get the vertex of id */
 	const DMSGVertex & get_vertex(long id) const;
+	/* get the rows of vectors of vertices (not built if the graph is read, or vectors are sparse) */
+	const DMSGMatrix & get_matrix() const { return matrix; }
 
 	friend class DMSGraphBuilder;
 	friend class DMSGraphWriter;
 	friend class DMSGraphReader;
 	friend class DMSGIter_Random;
 };
-/* map from vertex-id to mutant-id(s) */
+/* contiguous ids of vertices (or mutants) in index and hierarchy */
+class DMSGSpan {
+public:
+	DMSGSpan(const long * b, const long * e) : first(b), last(e) {}
+	const long * begin() const { return first; }
+	const long * end() const { return last; }
+	size_t size() const { return last - first; }
+	long operator [] (size_t k) const { return first[k]; }
+private:
+	const long * first, * last;
+};
+/* 
+*	index between mutants and vertices. Mutant ids are mapped by a dense array while
+*	they are dense (less than 4 times the number of mutants), and by a hash table once
+*	a sparse id is added. index_mutants() builds the reverse index, where mutants of
+*	vertex v are in mut_ids[mut_offsets[v], mut_offsets[v + 1]).
+* */
 class DMSGVexIndex {
 protected:
-	/* map from vertex id to mutant id(s) */
-	std::map<long, long> mid_vex;
-	/* map from vertex id to node */
-	std::map<long, DMSGVertex *> vid_vex;
+	/* vertex id of each mutant id (-1 for none), while ids are dense */
+	std::vector<long> mid_table;
+	/* map from mutant id to vertex id, once ids are sparse */
+	std::unordered_map<long, long> mid_hash;
+	/* whether mutant ids are kept in mid_hash */
+	bool sparse;
+	/* number of mutants in index */
+	unsigned int mnum;
+	/* vertices indexed by their id, null for ids not in index */
+	std::vector<DMSGVertex *> vid_vex;
+	/* number of mutants linked with each vertex */
+	std::vector<unsigned int> vid_mutants;
+	/* number of vertices in index */
+	unsigned int vnum;
+
+	/* whether the reverse index is up to date */
+	bool indexed;
+	/* offsets of mutants of each vertex in mut_ids */
+	std::vector<unsigned int> mut_offsets;
+	/* mutant ids grouped by their vertices */
+	std::vector<long> mut_ids;
 
 	/* only add vertex into the index without linked mutant */
 	void add(DMSGVertex &);
 	/* link a new mutant id with vertex */
 	void add(long, DMSGVertex &);
+	/* remove the mutant from index, and return the id of its vertex */
+	long remove(long);
+	/* remove the vertex (without mutants) from index */
+	void remove(DMSGVertex &);
+	/* move mutants from dense array into hash table */
+	void to_sparse();
+	/* build reverse index from vertices to their mutants */
+	void index_mutants();
 	/* clear the index from mutant to node */
 	void clear();
 public:
@@ -168,30 +345,108 @@ public:
 	bool has_mutant(long mid) const;
 	/* get the id of node for mutant */
 	long vertex_of_mutant(long mid) const;
+	/* get the ids of mutants in vertex (after graph is built or read) */
+	DMSGSpan mutants_of(long vid) const;
+	/* get the number of mutants in vertex */
+	unsigned int number_of_mutants(long vid) const { return has_vertex(vid) ? vid_mutants[vid] : 0; }
+	/* put the ids of all mutants in index into list (ascending) */
+	void get_mutants(std::vector<long> &) const;
 
-	unsigned int number_of_mutants() const { return mid_vex.size(); }
-	unsigned int number_of_vertices() const { return vid_vex.size(); }
+	unsigned int number_of_mutants() const { return mnum; }
+	unsigned int number_of_vertices() const { return vnum; }
 
 	friend class DMSGraphBuilder;
 	friend class DMSGraphWriter;
 	friend class DMSGraphReader;
 };
-/* hierarchy for MSG vertex by their degrees */
+/* marks on dense vertex ids, all cleared at once by stamping a new epoch */
+class DMSGMarks {
+protected:
+	/* epoch when each id is marked (0 for never) */
+	std::vector<unsigned int> stamps;
+	/* current epoch, ids stamped with it are marked */
+	unsigned int epoch;
+public:
+	DMSGMarks() : stamps(), epoch(1) {}
+	~DMSGMarks() {}
+
+	/* make room for ids in [0, n) */
+	void resize(size_t n) { if (stamps.size() < n) stamps.resize(n, 0); }
+	/* unmark all ids */
+	void reset() {
+		if (++epoch == 0) {
+			std::fill(stamps.begin(), stamps.end(), 0U);
+			epoch = 1;
+		}
+	}
+	/* whether the id is marked */
+	bool has(long id) const { return stamps[id] == epoch; }
+	/* mark the id */
+	void mark(long id) { stamps[id] = epoch; }
+	/* unmark the id */
+	void unmark(long id) { stamps[id] = 0; }
+	/* mark the id, and return false if it has been marked */
+	bool insert(long id) {
+		if (stamps[id] == epoch) return false;
+		stamps[id] = epoch; return true;
+	}
+};
+/* FIFO queue of vertex ids on a reused array */
+class DMSGQueue {
+protected:
+	std::vector<long> items;
+	size_t head;
+public:
+	DMSGQueue() : items(), head(0) {}
+	~DMSGQueue() {}
+
+	/* reserve room for n ids */
+	void reserve(size_t n) { items.reserve(n); }
+	/* remove all ids (keeping the array) */
+	void clear() { items.clear(); head = 0; }
+	bool empty() const { return head == items.size(); }
+	void push(long id) { items.push_back(id); }
+	long pop() { return items[head++]; }
+};
+/* 
+*	hierarchy of vertices by their degrees. sort() buckets the vertices by counting
+*	their degrees into one array in the order of linking (degree descending, and the
+*	latest added first in each level), where level i (the ith smallest degree) is at
+*	ids[offsets[i + 1], offsets[i]), so vertices of a range of degrees are contiguous.
+* */
 class DMSGHierarchy {
 protected:
-	std::map<BitSeq::size_t, std::list<long> *> degree_map;
+	/* vertices (and their degrees) in the order of adding */
+	std::vector<std::pair<long, BitSeq::size_t> > entries;
+	/* whether each vertex (by id) is removed, until its entry is dropped by compact() */
+	std::vector<char> removed;
+	/* vertices whose degrees are changed, until their entries are updated by compact() */
+	std::vector<std::pair<long, BitSeq::size_t> > regraded;
+	/* degrees of levels (ascending) */
 	std::vector<BitSeq::size_t> sort_list;
+	/* level of each degree (-1 for none) */
+	std::vector<int> level_of;
+	/* vertex ids bucketed by levels */
+	std::vector<long> ids;
+	/* bounds of levels in ids (descending) */
+	std::vector<size_t> offsets;
 
 	/* add a new vertex into the hierarchy */
 	void add(const DMSGVertex & vertex);
-	/* sort the degrees in sort_list */
+	/* mark the vertex removed from hierarchy (until compact() and sort(), it is still in entries and levels) */
+	void remove(const DMSGVertex & vertex);
+	/* put the vertex into the level of its new degree (after compact() and sort()) */
+	void regrade(const DMSGVertex & vertex);
+	/* drop the entries of vertices removed, and update those of vertices regraded */
+	void compact();
+	/* bucket vertices added by their degrees */
 	void sort();
 	/* clear the nodes in hierarchy */
 	void clear();
 public:
 	/* create an empty hierarchy */
 	DMSGHierarchy();
-	/* clear all dynamically allocated list in hierarchy */
+	/* clear the hierarchy */
 	~DMSGHierarchy();
 	
 	/* get the list */
@@ -200,86 +455,154 @@ public:
 	bool has_vertices(BitSeq::size_t) const;
 	/* get the number of vertices at specified degree */
 	unsigned int number_of_vertices(BitSeq::size_t) const;
-	/* get the list of vertex id(s) for specified degree */
-	const std::list<long> & get_vertices(BitSeq::size_t) const;
+	/* get the vertex id(s) for specified degree */
+	DMSGSpan get_vertices(BitSeq::size_t) const;
+	/* get the vertex id(s) with degree in [a, b] (degree descending) */
+	DMSGSpan get_vertices_in(BitSeq::size_t, BitSeq::size_t) const;
 	/* get the number of levels */
 	int number_of_levels() const { return sort_list.size(); }
-	/* get the list of id(s) for nodes at specified level (location) */
-	const std::list<long> & get_vertices_at(int) const;
+	/* get the id(s) for nodes at specified level (location) */
+	DMSGSpan get_vertices_at(int) const;
+	/* get all vertex ids in the order of linking (degree descending) */
+	DMSGSpan get_link_order() const { return DMSGSpan(ids.data(), ids.data() + ids.size()); }
 
 	/* get total number of vertices in hierarchy */
-	unsigned int number_of_vertices() const;
+	unsigned int number_of_vertices() const { return ids.size(); }
 
 	friend class DMSGraphBuilder;
 	friend class DMSGraphReader;
 };
-/* virtual class for iterator */
-class DMSGIterator {
+/* 
+*	base of iterators, the strategy Iter (derived from it) rolls to next node by its
+*	roll_next() without virtual calls. Iterators live on the stack of the search, and
+*	visiting marks and queues are reused across iterators.
+* */
+template<class Iter> class DMSGIterator {
 protected:
 	const DMSGraph & graph;
-	std::set<long> records;
+	DMSGMarks & records;
 	const DMSGVertex * nextptr;
-	virtual void roll_next() { nextptr = nullptr; }
 public:
-	DMSGIterator(const DMSGraph & g) : graph(g), records(), nextptr(nullptr) {}
-	virtual ~DMSGIterator() { records.clear(); }
-	bool has_next() { return nextptr != nullptr; }
+	DMSGIterator(const DMSGraph & g, DMSGMarks & marks) : graph(g), records(marks), nextptr(nullptr) { records.reset(); }
+	bool has_next() const { return nextptr != nullptr; }
 	const DMSGVertex * next() {
 		const DMSGVertex * ans = nextptr;
-		roll_next();
+		static_cast<Iter *>(this)->roll_next();
 		return ans;
 	}
 };
 /* iterate from leaf to root */
-class DMSGIter_DownTop : public DMSGIterator {
+class DMSGIter_DownTop : public DMSGIterator<DMSGIter_DownTop> {
 protected:
-	std::queue<long> qlist;
+	DMSGQueue & qlist;
 	void roll_next();
+	friend class DMSGIterator<DMSGIter_DownTop>;
 public:
-	DMSGIter_DownTop(const DMSGraph & g) : DMSGIterator(g), qlist() {
-		const std::set<long> & list = g.get_leafs();
-		auto beg = list.begin(), end = list.end();
-		while (beg != end) qlist.push(*(beg++));
+	DMSGIter_DownTop(const DMSGraph & g, DMSGMarks & marks, DMSGQueue & queue) : DMSGIterator(g, marks), qlist(queue) {
+		qlist.clear();
+		if (g.is_frozen()) {
+			const std::vector<long> & list = g.get_leaf_list();
+			for (size_t k = 0; k < list.size(); k++) qlist.push(list[k]);
+		}
+		else {
+			const std::set<long> & list = g.get_leafs();
+			auto beg = list.begin(), end = list.end();
+			while (beg != end) qlist.push(*(beg++));
+		}
 		roll_next();
 	}
-	~DMSGIter_DownTop() { 
-		while (!qlist.empty()) qlist.pop();
-		records.clear(); 
-	}
+	~DMSGIter_DownTop() {}
 };
 /* iterate nodes in DMSG from root to leaf */
-class DMSGIter_TopDown : public DMSGIterator {
+class DMSGIter_TopDown : public DMSGIterator<DMSGIter_TopDown> {
 protected:
-	std::queue<long> qlist;
+	DMSGQueue & qlist;
 	void roll_next();
+	friend class DMSGIterator<DMSGIter_TopDown>;
 public:
-	DMSGIter_TopDown(const DMSGraph & g) : DMSGIterator(g), qlist() {
-		const std::set<long> & list = g.get_roots();
-		auto beg = list.begin(), end = list.end();
-		while (beg != end) qlist.push(*(beg++));
+	DMSGIter_TopDown(const DMSGraph & g, DMSGMarks & marks, DMSGQueue & queue) : DMSGIterator(g, marks), qlist(queue) {
+		qlist.clear();
+		if (g.is_frozen()) {
+			const std::vector<long> & list = g.get_root_list();
+			for (size_t k = 0; k < list.size(); k++) qlist.push(list[k]);
+		}
+		else {
+			const std::set<long> & list = g.get_roots();
+			auto beg = list.begin(), end = list.end();
+			while (beg != end) qlist.push(*(beg++));
+		}
 		roll_next();
 	}
-	~DMSGIter_TopDown() {
-		while (!qlist.empty()) qlist.pop();
-		records.clear();
-	}
+	~DMSGIter_TopDown() {}
 };
-/* iterate nodes in DMSG randomly */
-class DMSGIter_Random : public DMSGIterator {
+/* iterate nodes in DMSG randomly (by their ids) */
+class DMSGIter_Random : public DMSGIterator<DMSGIter_Random> {
 protected:
-	std::map<long, DMSGVertex *>::const_iterator cursor, end;
+	size_t cursor;
 	void roll_next();
+	friend class DMSGIterator<DMSGIter_Random>;
 public:
-	DMSGIter_Random(const DMSGraph & g) : DMSGIterator(g) {
-		cursor = g.vertices.begin();
-		end = g.vertices.end();
+	DMSGIter_Random(const DMSGraph & g, DMSGMarks & marks) : DMSGIterator(g, marks), cursor(0) {
 		roll_next();
 	}
-	~DMSGIter_Random() {
-		records.clear();
-	}
+	~DMSGIter_Random() {}
+};
+
+/*
+*	Bit-transposed kill matrix of the vertices in hierarchy: for each test, the bitset
+*	of vertices killed by it. Vertices are located in the order they are linked
+*	(degree descending), so the vertices subsumed by x are all located before its level,
+*	and are the AND of the columns of the tests killing x over that prefix.
+* */
+class DMSGTestColumns {
+protected:
+	/* vertex ids in the order of linking */
+	std::vector<long> order;
+	/* location of the first vertex at the level of vertex (by id) */
+	std::vector<size_t> bounds;
+	/* number of tests (columns) */
+	BitSeq::size_t tests;
+	/* number of words in a column (padded to vector width) */
+	size_t stride;
+	/* columns of tests, stride words per test */
+	word * columns;
+public:
+	DMSGTestColumns() : order(), bounds(), tests(0), stride(0), columns(nullptr) {}
+	~DMSGTestColumns() { clear(); }
+
+	/* transpose the vectors of vertices in (sorted) hierarchy */
+	void build(const DMSGHierarchy &, const DMSGVexIndex &);
+	/* release the columns */
+	void clear();
+
+	/* number of words of a row of vertices */
+	size_t row_words() const { return stride; }
+	/* id of the vertex at location */
+	long vertex_at(size_t k) const { return order[k]; }
+	/* put the vertices subsumed by x into row (stride words), and return the number of words in use (the others up to vector width are cleared) */
+	size_t subsumed_by(const DMSGVertex & x, word * row) const;
+	/* put the vertices before bound subsumed by the vector into row, as above */
+	size_t subsumed_by(const BitSeq &, size_t bound, word * row) const;
+	/* put the vertices from first on subsuming the vector (killed by none of the other tests) into row (stride words), 
+	and return the number of words in use */
+	size_t subsuming(const BitSeq &, size_t first, word * row) const;
 };
 
+/* call work(t) on each of n threads, and rethrow the first exception of them once all are joined */
+template<class Work> void run_threads(unsigned int n, Work work) {
+	std::vector<std::exception_ptr> errors(n);
+	std::vector<std::thread> workers;
+	for (unsigned int t = 0; t < n; t++) {
+		workers.push_back(std::thread([t, &work, &errors]() {
+			try { work(t); }
+			catch (...) { errors[t] = std::current_exception(); }
+		}));
+	}
+	for (size_t t = 0; t < workers.size(); t++) workers[t].join();
+	for (size_t t = 0; t < errors.size(); t++)
+		if (errors[t]) std::rethrow_exception(errors[t]);
+}
+
 /* builder for DMSG */
 class DMSGraphBuilder {
 protected:
@@ -290,10 +613,81 @@ protected:
 	char state;
 
 	unsigned int compares;
+	unsigned int filtered;
+	bool compress;
+
+	/* number of threads linking the vertices of a level */
+	unsigned int threads;
+	/* whether threads link vertices across levels once their supersets are in graph */
+	bool pipeline;
+
+	/* scratch of link phase on dense vertex ids (one per thread), sized once per build */
+	struct Scratch {
+		/* vertices visited by find_direct_subsumed */
+		DMSGMarks visited;
+		/* vertices tagged by tag_ancestors or tag_descendants */
+		DMSGMarks tagged;
+		/* candidates directly subsumed by the vertex to link */
+		DMSGMarks direct;
+		/* vertices returned by the iterator */
+		DMSGMarks records;
+		/* queue of tag_ancestors and tag_descendants */
+		DMSGQueue queue;
+		/* queue of the iterator */
+		DMSGQueue iter_queue;
+		/* ids put into direct (some unmarked later) */
+		std::vector<long> candidates;
+		/* direct subsumed nodes of the node linked by pipeline */
+		std::vector<long> subsumed;
+		/* vertices subsumed by the node (in test columns) */
+		std::vector<word> row;
+		/* rows subsumed by the node (in matrix) */
+		std::vector<word> mask;
+		/* comparisons between clusters made on this scratch */
+		unsigned int compares;
+		/* comparisons rejected by signatures on this scratch */
+		unsigned int filtered;
+
+		Scratch() : compares(0), filtered(0) {}
+		/* make room for ids in [0, n) */
+		void resize(size_t);
+	};
+	std::vector<Scratch> scratches;
+	/* kill matrix transposed for Inverted strategy */
+	DMSGTestColumns columns;
+	/* number of levels linked by each strategy (DownTop to Inverted) */
+	unsigned int levels_by[4];
+	/* vertices sampled by the last probe of Auto, and their direct subsumed nodes found by the strategy chosen */
+	std::vector<long> sampled;
+	std::vector<std::vector<long> > sampled_DSs;
+	/* vertices in graph by their vectors (built by the first insert_mutant() after reopen(), until close()) */
+	BitHashTable * clusters;
+	/* vertices created by insert_mutant() since the test columns are built */
+	std::vector<long> inserted;
 public:
 	DMSGraphBuilder(DMSGVexIndex &, DMSGraph &, DMSGHierarchy &);
 	~DMSGraphBuilder();
 
+	/* whether vectors of new nodes are compacted to sparse ones when it saves memory */
+	void set_compression(bool value) { compress = value; }
+	/* number of threads linking the vertices of one level concurrently (the graph is the same as by one) */
+	void set_threads(unsigned int value) { threads = (value == 0) ? 1 : value; }
+
+	/* whether threads link each vertex as soon as the vertices it may subsume are in graph, 
+	instead of level by level (the graph is the same) */
+	void set_pipeline(bool value) { pipeline = value; }
+
+	/* minimum number of vertices in a level to link them by threads */
+	static const size_t MinimumParallelVertices = 16;
+	/* maximum number of vertices not in graph compared to decide whether a vertex can be linked */
+	static const size_t MaximumSupersetScan = 4096;
+	/* number of vertices of a level on which Auto probes each strategy */
+	static const size_t AutoSampleVertices = 8;
+	/* maximum number of words in the reach rows of Reduction (1 GB), beyond which Inverted is used */
+	static const size_t MaximumReachWords = 1 << 27;
+	/* maximum number of nodes inserted (compared one by one) in update, beyond which the test columns are built again */
+	static const size_t MaximumInsertedScan = 1024;
+
 	/* closed engine */
 	static const char END = 0;
 	/* after open(), before sort_nodes(), available for input_node() */
@@ -302,6 +696,8 @@ public:
 	static const char SRT = 2;
 	/* after link_nodes(), before close() */
 	static const char CMP = 3;
+	/* after reopen(), before close(), available for insert_mutant() and remove_mutant() */
+	static const char UPD = 4;
 	/* get current state */
 	char get_state() const { return state; }
 
@@ -314,31 +710,94 @@ public:
 	/* sort the nodes in hierarchy */
 	bool sort_nodes();
 	/* build up the edges between nodes in graph */
-	bool link_nodes(const char);
+	bool link_nodes(char);
+	/* instead of link_nodes, put only the nodes subsumed by no other into graph (without edges); the node 
+	of mutants killed by no test (which subsumes all) is left out, so they are the dominator clusters */
+	bool link_dominators();
 	/* close the engine for building DMSG */
 	bool close();
 
+	/* start to update the graph built or read before by new (or removed) mutants, a frozen graph is thawed */
+	bool reopen();
+	/* put a new mutant into graph: into the node of the same vector, or into a new node linked between its 
+	direct subsuming and subsumed nodes (the edges from the ones to the others are removed) */
+	DMSGVertex * insert_mutant(const KillVector &);
+	/* remove the mutant from graph, and its node once no mutant is left in it (its subsuming nodes 
+	are linked to its subsumed ones unless reachable by other paths) */
+	void remove_mutant(long);
+	/* extend the vectors of nodes by the tests appended (up to the number), where the appended tests killing 
+	each mutant (ascending, mutants killed by none are left out) are mapped from its id; the nodes whose mutants 
+	differ in them are split, and only the splits and the nodes above them are relinked */
+	void append_tests(BitSeq::size_t, const std::unordered_map<long, std::vector<BitSeq::size_t> > &);
+
 	/* to determine the iterator to link nodes from down (leafs) to top (roots) */
 	static const char DownTop = 0;
 	/* to determine the iterator to link nodes from top (roots) to down (leafs) */
 	static const char TopDown = 1;
 	/* to determine the iterator to link nodes randomly */
 	static const char Random = 2;
-
-	/* get the number of comparisons between clusters */
+	/* to link nodes by the AND of test columns of kill matrix, instead of iterating graph */
+	static const char Inverted = 3;
+	/* to link nodes by transitive reduction of the subsumption rows of all nodes (test columns) computed by threads, 
+	instead of pruning descendants in graph; it takes (number of nodes)^2 bits */
+	static const char Reduction = 4;
+	/* to link each level by the strategy (DownTop, TopDown, Random or Inverted) taking the least time on a sample 
+	of the level, probed again whenever the graph doubles; the levels between probes are linked by pipeline when it is set */
+	static const char Auto = 5;
+
+	/* get the number of comparisons between clusters (by their vectors) */
 	unsigned int get_comparisons() const { return compares; }
+	/* get the number of comparisons between clusters rejected by signatures (without comparing vectors) */
+	unsigned int get_filtered() const { return filtered; }
+	/* get the number of levels linked by the strategy (DownTop, TopDown, Random or Inverted) */
+	unsigned int get_levels_linked_by(char strategy) const { 
+		return (strategy >= DownTop && strategy <= Inverted) ? levels_by[(int)strategy] : 0;
+	}
 
 private:
-	/* get a new iterator for nodes in DMSG (by strategy) -- which is dynamicaly created */
-	DMSGIterator & get_iterator(char);
-	/* tag the id(s) of nodes subsuming x (its ancestors) in search space */
-	void tag_ancestors(const DMSGVertex &, std::set<long> &);
-	/* tag the id(s) of nodes subsumed by x (its children) in search space */
-	void tag_descendants(const DMSGVertex &, std::set<long> &);
-	/* find the nodes in current graph directly subsumed by x, and put their id(s) into set */
-	void find_direct_subsumed(const DMSGVertex &, std::set<long> &, char);
+	/* mark the id(s) of nodes subsuming x (its ancestors) as visited, stopping at visited ones */
+	void tag_ancestors(const DMSGVertex &, Scratch &);
+	/* mark the id(s) of nodes subsumed by x (its descendants) as visited, and remove them from direct candidates */
+	void tag_descendants(const DMSGVertex &, Scratch &);
+	/* find the nodes in current graph directly subsumed by x, and put their id(s) into list (ascending); the graph is only read */
+	void find_direct_subsumed(const DMSGVertex &, std::vector<long> &, char, Scratch &);
+	/* search the nodes directly subsumed by x in those visited by iterator (scanned: decided by the mask of rows before bound) */
+	template<class Iter> void search_subsumed(const DMSGVertex &, std::vector<long> &, Iter &, Scratch &, bool, size_t);
+	/* find the nodes directly subsumed by x in the AND of its test columns, without their descendants in graph */
+	void find_inverted_subsumed(const DMSGVertex &, std::vector<long> &, Scratch &);
+	/* call work(k, scratch) for k in [0, n), by threads (each on its own scratch) when n is large enough */
+	template<class Work> void run_parallel(size_t, Work);
+	/* put the vertices in graph into clusters (by vectors) and test columns, once the first mutant is updated */
+	void index_vertices();
+	/* sort the hierarchy (without the vertices removed), and put its vertices into test columns */
+	void index_columns();
+	/* whether y is subsumed by any of the nodes */
+	bool is_dominated(const DMSGVertex &, const std::vector<DMSGVertex *> &, Scratch &);
 	/* link the nodes at ith level in hierarchy to the nodes in current graph */
 	void link_level(int, char);
+	/* link the nodes in [first, last) of the link order by threads stealing work, each node once all its 
+	supersets are linked (the input edges are ordered by order_in_edges() afterwards) */
+	void link_pipeline(char, size_t, size_t);
+	/* link all nodes by transitive reduction of their subsumption rows */
+	void link_reduction();
+	/* link the levels by the strategy probed as the cheapest, probed again once the graph doubles 
+	(the levels between probes are linked by pipeline when it is set) */
+	void link_adaptive();
+	/* get the strategy linking a sample of ith level in the least time (only the comparisons of it are counted, 
+	and the nodes it finds for the sample are kept for linking them) */
+	char probe_strategy(int);
+	/* find the nodes directly subsumed by x, or take the ones found for it by the last probe */
+	void find_or_reuse_subsumed(const DMSGVertex &, std::vector<long> &, char, Scratch &);
+	/* reduce the row of kth node to its direct subsumed nodes (others in row are in their reach) */
+	void reduce_row(const word *, size_t, size_t, std::vector<long> &, Scratch &);
+	/* link x to its direct subsumed nodes and put it into graph (when linked by pipeline) */
+	void commit_vertex(DMSGVertex &, const std::vector<long> &);
+	/* add the counters of scratches to the builder */
+	void collect_counters();
+	/* put the input edges of nodes in the order they are linked level by level */
+	void order_in_edges(const DMSGSpan &);
+
+	friend class DMSGLinkSchedule;
 };
 
 /* writer for DMSG */
@@ -365,8 +824,8 @@ private:
 	void endin_vertices();
 	void write_subsumes(const DMSGraph &);
 	void endin_subsumes();
-	void begin_indexlib(const DMSGVexIndex &);
-	void write_indexlib(const DMSGVexIndex &);
+	void begin_indexlib(const DMSGraph &, const DMSGVexIndex &);
+	void write_indexlib(const DMSGraph &, const DMSGVexIndex &);
 	void endin_indexlib();
 };
 /* reader for DMSG */
@@ -383,7 +842,7 @@ private:
 	std::ifstream in;
 
 	void initial_graph(DMSGraph &, DMSGVexIndex &, DMSGHierarchy &);
-	void read_vertices(DMSGVexIndex &, DMSGHierarchy &);
+	void read_vertices(DMSGraph &, DMSGVexIndex &, DMSGHierarchy &);
 	void read_subsumes(DMSGVexIndex &, DMSGraph &);
 	void read_indexlib(DMSGVexIndex &);
 	void rebuild_graph(DMSGVexIndex &, DMSGraph &);
@@ -0,0 +1,121 @@
+#include "kmat.h"
+#include <cstring>
+#include <iostream>
+
+/* magic number at the head of kill-matrix file */
+static const char KMAT_MAGIC[8] = { 'D', 'M', 'S', 'G', 'K', 'M', 'A', 'T' };
+/* version of kill-matrix format */
+static const unsigned int KMAT_VERSION = 1;
+/* bytes of the fixed fields in a row */
+static const size_t KMAT_ROW_HEAD = sizeof(long long) + 2 * sizeof(unsigned int);
+
+/* number of bytes padded to 8 */
+static inline size_t padded_bytes(size_t bytes) { return (bytes + 7) / 8 * 8; }
+
+// KillMatrixWriter
+void KillMatrixWriter::open(const std::string & path, BitSeq::size_t testnum, BitSeq::size_t bias) {
+	close();
+	out.open(path, std::ios::binary);
+	if (!out.is_open()) throw "Invalid kill-matrix file: ", path;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, KMAT_MAGIC, sizeof(KMAT_MAGIC));
+	header.version = KMAT_VERSION;
+	header.testnum = testnum; header.bias = bias;
+	header.row_words = (testnum + WORD_BITS - 1) / WORD_BITS;
+	out.write((char *)(&header), sizeof(header));
+}
+void KillMatrixWriter::write(const KillVector & vec) {
+	/* validation */
+	if (!out.is_open())
+		throw "Invalid access: not opened stream";
+	const BitSeq & vector = vec.get_vector();
+	if (vector.bit_number() != header.testnum)
+		throw "Invalid kill-vector length: ", vector.bit_number();
+
+	long long mid = vec.get_mutant_ID();
+	unsigned int quantity = vec.get_quantity();
+	/* an id takes 32 bits, keep words unless ids take less space */
+	bool sparse = (unsigned long long)quantity * sizeof(unsigned int) < header.row_words * sizeof(word);
+	unsigned int number = sparse ? quantity : DENSE_ROW;
+
+	out.write((char *)(&mid), sizeof(long long));
+	out.write((char *)(&quantity), sizeof(unsigned int));
+	out.write((char *)(&number), sizeof(unsigned int));
+	if (sparse) {
+		if (vector.is_sparse())
+			out.write((char *)(vector.get_positions()), sizeof(unsigned int) * number);
+		else {
+			for (BitSeq::size_t i = vector.first_bit(); i < vector.bit_number(); i = vector.next_bit(i))
+				out.write((char *)(&i), sizeof(unsigned int));
+		}
+		static const char zeros[8] = { 0 };
+		size_t bytes = sizeof(unsigned int) * number;
+		out.write(zeros, padded_bytes(bytes) - bytes);
+	}
+	else {
+		if (vector.is_sparse()) {
+			BitSeq dense(vector); dense.expand();
+			out.write((char *)(dense.get_words()), sizeof(word) * header.row_words);
+		}
+		else out.write((char *)(vector.get_words()), sizeof(word) * header.row_words);
+	}
+	header.mutants++;
+}
+void KillMatrixWriter::close() {
+	if (out.is_open()) {
+		/* complete the number of rows in header */
+		out.seekp(0, std::ios::beg);
+		out.write((char *)(&header), sizeof(header));
+		out.close();
+	}
+}
+
+// KillMatrixReader
+KillMatrixReader::KillMatrixReader(const std::string & path) : file(path), header(), cursor(nullptr) {
+	if (file.size() < sizeof(header) || memcmp(file.begin(), KMAT_MAGIC, sizeof(KMAT_MAGIC)) != 0)
+		throw "Invalid kill-matrix file: ", path;
+	memcpy(&header, file.begin(), sizeof(header));
+	if (header.version != KMAT_VERSION)
+		throw "Invalid kill-matrix version: ", header.version;
+	if (header.row_words != (header.testnum + WORD_BITS - 1) / WORD_BITS)
+		throw "Invalid kill-matrix row: ", header.row_words;
+	reset();
+}
+bool KillMatrixReader::is_matrix(const std::string & path) {
+	if (!MappedFile::can_map(path)) return false;
+	std::ifstream in(path.c_str(), std::ios::in | std::ios::binary);
+	char magic[sizeof(KMAT_MAGIC)];
+	if (!in.read(magic, sizeof(magic))) return false;
+	return memcmp(magic, KMAT_MAGIC, sizeof(KMAT_MAGIC)) == 0;
+}
+void KillMatrixReader::reset() { cursor = file.begin() + sizeof(header); }
+bool KillMatrixReader::next(KillVector & vec) {
+	if (vec.vector.bit_number() != header.testnum)
+		throw "Invalid kill-vector length: ", vec.vector.bit_number();
+	if (cursor + KMAT_ROW_HEAD > file.end()) return false;
+
+	long long mid; unsigned int quantity, number;
+	memcpy(&mid, cursor, sizeof(long long));
+	memcpy(&quantity, cursor + sizeof(long long), sizeof(unsigned int));
+	memcpy(&number, cursor + sizeof(long long) + sizeof(unsigned int), sizeof(unsigned int));
+	const char * payload = cursor + KMAT_ROW_HEAD;
+
+	size_t bytes = (number == KillMatrixWriter::DENSE_ROW) ?
+		sizeof(word) * header.row_words : padded_bytes(sizeof(unsigned int) * number);
+	if (payload + bytes > file.end())
+		throw "Invalid kill-matrix row of mutant: ", mid;
+
+	/* rows are copied into the words of vector (payload is aligned to 8 bytes) */
+	if (number == KillMatrixWriter::DENSE_ROW)
+		vec.vector.set_words((const word *)payload, header.row_words);
+	else {
+		vec.vector.set_words(nullptr, 0);
+		const unsigned int * ids = (const unsigned int *)payload;
+		for (unsigned int k = 0; k < number; k++) vec.vector.set_bit(ids[k], BIT_1);
+	}
+	vec.mid = mid; vec.quantity = quantity;
+
+	cursor = payload + bytes;
+	return true;
+}
@@ -0,0 +1,100 @@
+#pragma once
+/*
+	File: kmat.h
+	-Aim: to define binary kill-matrix files, where kill-vectors of score function are kept without text
+	-Dat: Oct 16th, 2026
+	-Art: Lin Huan
+	-Cls:
+		[1] KillMatrixWriter
+		[2] KillMatrixReader
+	-Fmt: integers in native (little-endian) order, every record is aligned to 8 bytes
+		header:	"DMSGKMAT" version(u32) flags(u32) mutants(u64) testnum(u32) bias(u32) row_words(u64) reserved(u64 * 3)
+		row:	mid(i64) quantity(u32) number(u32) payload
+			number == DENSE_ROW:	row_words words, where test t is bit (t % 64) of word (t / 64)
+			otherwise:				number sorted ids of tests (u32), padded to 8 bytes
+*/
+
+#include "bitseq.h"
+#include "text.h"
+#include <string>
+#include <fstream>
+
+class KillMatrixWriter;
+class KillMatrixReader;
+
+/* header of kill-matrix file (64 bytes) */
+struct KillMatrixHeader {
+	/* "DMSGKMAT" */
+	char magic[8];
+	/* version of format */
+	unsigned int version;
+	/* not used (0) */
+	unsigned int flags;
+	/* number of rows (mutants) */
+	unsigned long long mutants;
+	/* number of tests (bits in row) */
+	unsigned int testnum;
+	/* id of the first test in score function */
+	unsigned int bias;
+	/* number of words in a dense row */
+	unsigned long long row_words;
+	/* not used (0) */
+	unsigned long long reserved[3];
+};
+
+/* writer of kill-vectors into kill-matrix file row by row */
+class KillMatrixWriter {
+public:
+	/* number in row for dense payload */
+	static const unsigned int DENSE_ROW = 0xFFFFFFFFU;
+
+	/* create an initial writer */
+	KillMatrixWriter() : out(), header() {}
+	/* close the file (and complete the header) */
+	~KillMatrixWriter() { close(); }
+
+	/* open the file for kill-vectors of specified tests */
+	void open(const std::string &, BitSeq::size_t testnum, BitSeq::size_t bias);
+	/* write kill-vector as the next row (sparse if ids take less space than words) */
+	void write(const KillVector &);
+	/* complete the header with number of rows and close the file if it's opened */
+	void close();
+
+private:
+	/* output stream for file */
+	std::ofstream out;
+	/* header, where mutants counts the rows written */
+	KillMatrixHeader header;
+};
+
+/* reader of kill-vectors from mapped kill-matrix file */
+class KillMatrixReader {
+public:
+	/* map the kill-matrix file */
+	KillMatrixReader(const std::string &);
+	/* unmap the file */
+	~KillMatrixReader() {}
+
+	/* whether the file (regular) is a kill-matrix file */
+	static bool is_matrix(const std::string &);
+
+	/* number of rows (mutants) */
+	unsigned long long number_of_mutants() const { return header.mutants; }
+	/* number of tests */
+	BitSeq::size_t get_test_number() const { return header.testnum; }
+	/* id of the first test */
+	BitSeq::size_t get_bias() const { return header.bias; }
+
+	/* overwrite vec (created by KillVector(testnum)) by the next row, false at the end */
+	bool next(KillVector & vec);
+	/* go back to the first row */
+	void reset();
+
+private:
+	/* mapped file */
+	MappedFile file;
+	/* header copied from file */
+	KillMatrixHeader header;
+	/* the next row */
+	const char * cursor;
+};
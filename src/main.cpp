@@ -1,7 +1,13 @@
 #include "text.h"
 #include "dmsg.h"
+#include "classify.h"
+#include "kmat.h"
 #include <time.h>
 #include <iostream>
+#include <vector>
+#include <thread>
+#include <cstring>
+#include <cstdlib>
 
 /*
 	-File : main.cpp
@@ -9,59 +15,99 @@
 	-Arth : Huan Lin
 	-Usage:
 		To execute DMSGen.exe by the following commands.
-			DMSGen [bias] [tnum] [input] [output]?
+			DMSGen [options]* [bias] [tnum] [input] [output]?
+		where input "-" (or a pipe) is read from the standard input while it is written.
 		The lines in input file must be:
 			${mutant_id} '[' ${length} ']' ':' {'t'${test_id}}*
+		or input is a binary kill-matrix file (see kmat.h).
+		Options:
+			--dedup=hash|trie	how identical kill-vectors are clustered (hash)
+			--threads=N		number of threads to parse input and link vertices of a level (number of cores)
+			--schedule=level|steal	link vertices level by level, or by threads stealing vertices whose supersets are linked (steal)
+			--strategy=NAME		how direct subsumed vertices are searched: downtop, topdown, random, inverted, reduction or auto (auto)
+			--mode=full|dominators	generate the whole DMSG, or only its dominator clusters and their mutants without edges (full)
+			--update=FILE		update the DMSG in FILE by the mutants in input (replacing those already in it) instead of generating it; 
+						with more tests than in FILE, the input gives kills of the tests appended to its suite
+			--convert=FILE		convert the text input into kill-matrix FILE without generating DMSG
 */
 
-unsigned int generateDMSG(BitSeq::size_t, int, const std::string &, const std::string &);
+/* options given as "--name=value" in command line */
+struct DMSGenOptions {
+	/* cluster identical kill-vectors by hash table ("hash") or bit-trie ("trie") */
+	std::string dedup;
+	/* number of threads to parse and cluster input, and to link vertices of a level */
+	unsigned int threads;
+	/* link vertices level by level ("level") or by work-stealing threads across levels ("steal") */
+	std::string schedule;
+	/* strategy to search direct subsumed vertices (DMSGraphBuilder::DownTop to Auto) */
+	char strategy;
+	/* generate the whole DMSG ("full") or only the dominator clusters ("dominators") */
+	std::string mode;
+	/* kill-matrix file where the input is converted (empty to generate DMSG) */
+	std::string convert;
+	/* DMSG file updated by the mutants in input (empty to generate DMSG) */
+	std::string update;
+
+	DMSGenOptions() : dedup("hash"), threads(std::thread::hardware_concurrency()), schedule("steal"), 
+		strategy(DMSGraphBuilder::Auto), mode("full") {
+		if (threads == 0) threads = 1;
+	}
+};
+
+unsigned int generateDMSG(BitSeq::size_t, int, const std::string &, const std::string &, const DMSGenOptions &);
+unsigned int convertToMatrix(BitSeq::size_t, int, const std::string &, const std::string &);
+unsigned int updateDMSG(BitSeq::size_t, int, const std::string &, const std::string &, const DMSGenOptions &);
+bool openInput(const std::string &, size_t, MappedFile *&, BlockReader *&, const char *&, const char *&);
+double densityOfInput(BitSeq::size_t, int, const char *, const char *, int);
+double densityOfMatrix(KillMatrixReader &, int);
 void summaryOfDMSG(unsigned int, const DMSGVexIndex &, const DMSGHierarchy &, const DMSGraph &, std::ostream &);
 
 /* generate DMSG from specified score function from input file, write it to the output file and return how many mutants are killed */
-unsigned int generateDMSG(BitSeq::size_t bias, int testnum, const std::string &input, const std::string &output) {
-	/* inputs */
-	LineReader reader(input);
-	KillVectorProducer producer(testnum, bias);
+unsigned int generateDMSG(BitSeq::size_t bias, int testnum, 
+	const std::string &input, const std::string &output, const DMSGenOptions & options) {
+	/* inputs: kill-matrix or text, which is mapped or streamed block by block */
+	MappedFile * file = nullptr; BlockReader * stream = nullptr; KillMatrixReader * matrix = nullptr;
+	const char * beg = nullptr, * end = nullptr; bool more = false;
+	if (KillMatrixReader::is_matrix(input)) {
+		matrix = new KillMatrixReader(input);
+		if (matrix->get_test_number() != (BitSeq::size_t)testnum || matrix->get_bias() != bias)
+			throw "Invalid kill-matrix for tests: ", matrix->get_test_number();
+	}
+	else more = openInput(input, KillVectorClassifier::block_characters(options.threads), file, stream, beg, end);
 
 	/* outputs */
 	DMSGraph graph; DMSGVexIndex index; DMSGHierarchy hierarchy;
 	DMSGraphBuilder builder(index, graph, hierarchy);
+	builder.set_threads(options.threads);
+	builder.set_pipeline(options.schedule == "steal");
 
 	/* intermediate */
-	BitTrieTree & tree = *(new BitTrieTree());
+	KillVectorClassifier & classifier = *(new KillVectorClassifier(
+		builder, testnum, bias, options.dedup == "trie"));
 	clock_t t0, t1, t2, t3;
 
-	std::cout << "Classify: "; t0 = clock();
-	/* parse I: create nodes and index from mutants to them */
-	builder.open(); unsigned int killed = 0;
-	while (reader.hasNext()) {
-		/* get the next line for kill-vector */
-		std::string line = reader.next();
-		const KillVector * vec = producer.produce(line);
-		if (vec == nullptr) continue;
-
-		/* calculate the killed mutants */
-		if (vec->get_quantity() > 0) killed++;
-
-		/* get the leaf for this vector */
-		BitTrie * leaf = tree.insert_vector(vec->get_vector());
-		if (leaf == nullptr) throw "Interpreting error!";
-		/* The first time it is created */
-		if (leaf->get_data() == nullptr) {
-			DMSGVertex * vex = builder.add_node(*vec);
-			leaf->set_data(vex);
-		}
-		/* The second or other time is only linked to mutant */
-		else {
-			DMSGVertex & vex = *((DMSGVertex *)(leaf->get_data()));
-			builder.add_index(vec->get_mutant_ID(), vex);
-		}
+	/* pre-pass: keep vertices of wide and sparse suites as sparse vectors (sampled from the first block) */
+	if (testnum > (int)BitSeq::INLINE_BITS && (matrix != nullptr ? densityOfMatrix(*matrix, 4096) 
+		: densityOfInput(bias, testnum, beg, end, 4096)) * 64 < 1.0)
+		builder.set_compression(true);
 
-		/* continue for the next */
-		delete vec;
+	std::cout << "Classify: "; t0 = clock();
+	/* parse I: create nodes and index from mutants to them (by threads on chunks of each block, or rows of matrix) */
+	builder.open();
+	while (more) {
+		classifier.classify(beg, end, options.threads);
+		more = (stream != nullptr) && stream->next(beg, end);
+	}
+	if (matrix != nullptr) {
+		KillVector row(testnum);
+		while (matrix->next(row)) classifier.classify(row);
 	}
-	/* release the trie tree */
-	delete &tree; t1 = clock();
+	unsigned int killed = classifier.number_of_killed();
+	/* release the trie tree or hash table, and the input */
+	delete &classifier; t1 = clock();
+	if (file != nullptr) delete file;
+	if (stream != nullptr) delete stream;
+	if (matrix != nullptr) delete matrix;
 	std::cout << (t1 - t0) << " ms.\n";
 
 	/* parse II: sort the hierarchy */
@@ -70,13 +116,113 @@ unsigned int generateDMSG(BitSeq::size_t bias, int testnum, const std::string &i
 	t2 = clock();
 	std::cout << (t2 - t1) << " ms.\n";
 
-	/* parse III: link the nodes and put them into graph */
+	/* parse III: link the nodes and put them into graph (or only put the dominators) */
 	std::cout << "Link: ";
-	builder.link_nodes(DMSGraphBuilder::Random);
+	if (options.mode == "dominators") builder.link_dominators();
+	else builder.link_nodes(options.strategy);
+
+	/* parse IV: end to parse, and freeze the graph into compact arrays */
+	builder.close(); graph.freeze(); t3 = clock();
+	std::cout << (t3 - t2) << " ms (" << builder.get_comparisons() << " comparisons, "
+		<< builder.get_filtered() << " rejected by signatures).\n";
+	if (options.strategy == DMSGraphBuilder::Auto && options.mode == "full") {
+		std::cout << "Levels linked by: downtop " << builder.get_levels_linked_by(DMSGraphBuilder::DownTop) 
+			<< ", topdown " << builder.get_levels_linked_by(DMSGraphBuilder::TopDown) 
+			<< ", random " << builder.get_levels_linked_by(DMSGraphBuilder::Random) 
+			<< ", inverted " << builder.get_levels_linked_by(DMSGraphBuilder::Inverted) << "\n";
+	}
+
+	/* write DMSG */
+	std::cout << "Writing DMSG to " << output << "......";
+	DMSGraphWriter writer;
+	writer.open(output);
+	writer.write(graph, index);
+	writer.close();
+	std::cout << "\n Complete\n\n";
+
+	/* print outputs */
+	summaryOfDMSG(killed, index, hierarchy, graph, std::cout);
+	std::cout << std::endl;
+
+	/* return */
+	return killed;
+}
+/* update the DMSG in options.update by the kill-vectors in input, write it to the output file and return how many mutants are killed */
+unsigned int updateDMSG(BitSeq::size_t bias, int testnum, 
+	const std::string & input, const std::string & output, const DMSGenOptions & options) {
+	/* read the DMSG to be updated */
+	DMSGraph graph; DMSGVexIndex index; DMSGHierarchy hierarchy;
+	DMSGraphReader reader; reader.open(options.update);
+	reader.read(graph, index, hierarchy); reader.close();
+	DMSGraphBuilder builder(index, graph, hierarchy);
+
+	/* tests in graph: inputs of more tests give the kills of tests appended to them, and fewer are rejected 
+	(before any mutant is removed) */
+	BitSeq::size_t tests = 0; DMSGSpan vids = hierarchy.get_link_order();
+	if (vids.size() > 0) tests = index.get_vertex(vids[0]).get_vector().bit_number();
+	if ((BitSeq::size_t)testnum < tests) {
+		std::cerr << "Invalid number of tests: " << testnum << " (the DMSG in \"" 
+			<< options.update << "\" has " << tests << " tests)" << std::endl;
+		exit(1);
+	}
+	bool appending = tests > 0 && tests < (BitSeq::size_t)testnum;
 
-	/* parse IV: end to parse */
-	builder.close(); t3 = clock();
-	std::cout << (t3 - t2) << " ms.\n";
+	/* inputs: kill-matrix or text, which is mapped or streamed block by block */
+	MappedFile * file = nullptr; BlockReader * stream = nullptr; KillMatrixReader * matrix = nullptr;
+	const char * beg = nullptr, * end = nullptr; bool more = false;
+	if (KillMatrixReader::is_matrix(input)) {
+		matrix = new KillMatrixReader(input);
+		if (matrix->get_test_number() != (BitSeq::size_t)testnum || matrix->get_bias() != bias)
+			throw "Invalid kill-matrix for tests: ", matrix->get_test_number();
+	}
+	else more = openInput(input, BlockReader::DefaultBlockCharacters, file, stream, beg, end);
+
+
+	/* replace the mutants in graph by their new vectors, or insert new ones (or collect kills of appended tests) */
+	std::cout << "Update: "; clock_t t0 = clock();
+	unsigned int inserted = 0, replaced = 0; std::unordered_map<long, std::vector<BitSeq::size_t> > appended;
+	auto apply = [&builder, &index, &inserted, &replaced, appending, tests, &appended](const KillVector & vec) {
+		long mid = vec.get_mutant_ID();
+		if (appending) {
+			/* only the appended tests killing the mutant are kept */
+			if (!index.has_mutant(mid)) throw "Undefined mutant: ", mid;
+			const BitSeq & bits = vec.get_vector(); BitSeq::size_t n = bits.bit_number();
+			for (BitSeq::size_t t = bits.next_bit(tests - 1); t < n; t = bits.next_bit(t)) appended[mid].push_back(t);
+		}
+		else if (index.has_mutant(mid)) {
+			/* the same vector is left in its node */
+			replaced++;
+			if (index.get_vertex(index.vertex_of_mutant(mid)).get_vector().equals(vec.get_vector())) return;
+			else builder.remove_mutant(mid);
+		}
+		else inserted++;
+		if (!appending) builder.insert_mutant(vec);
+	};
+	KillVectorProducer producer(testnum, bias); KillVector vec(testnum);
+	builder.reopen();
+	while (more) {
+		const char * cursor = beg;
+		while (cursor < end) {
+			const char * eol = (const char *)memchr(cursor, '\n', end - cursor);
+			if (eol == nullptr) eol = end;
+			bool valid = producer.produce(cursor, eol, vec);
+			cursor = eol + 1;
+			if (valid) apply(vec);
+		}
+		more = (stream != nullptr) && stream->next(beg, end);
+	}
+	if (matrix != nullptr) {
+		while (matrix->next(vec)) apply(vec);
+	}
+	if (appending) builder.append_tests(testnum, appended);
+	builder.close(); graph.freeze();
+	if (file != nullptr) delete file;
+	if (stream != nullptr) delete stream;
+	if (matrix != nullptr) delete matrix;
+	std::cout << (clock() - t0) << " ms (";
+	if (appending) std::cout << (testnum - tests) << " tests appended, " << graph.number_of_vertices() << " clusters, ";
+	else std::cout << inserted << " inserted, " << replaced << " replaced, ";
+	std::cout << builder.get_comparisons() << " comparisons, " << builder.get_filtered() << " rejected by signatures).\n";
 
 	/* write DMSG */
 	std::cout << "Writing DMSG to " << output << "......";
@@ -87,12 +233,87 @@ unsigned int generateDMSG(BitSeq::size_t bias, int testnum, const std::string &i
 	std::cout << "\n Complete\n\n";
 
 	/* print outputs */
+	std::vector<long> mids; index.get_mutants(mids);
+	unsigned int killed = 0;
+	for (size_t k = 0; k < mids.size(); k++)
+		if (index.get_vertex(index.vertex_of_mutant(mids[k])).get_degree() > 0) killed++;
 	summaryOfDMSG(killed, index, hierarchy, graph, std::cout);
 	std::cout << std::endl;
 
 	/* return */
 	return killed;
 }
+/* convert the text of score function into kill-matrix file, and return the number of rows */
+unsigned int convertToMatrix(BitSeq::size_t bias, int testnum, const std::string & input, const std::string & output) {
+	MappedFile * file = nullptr; BlockReader * stream = nullptr;
+	const char * beg = nullptr, * end = nullptr;
+	bool more = openInput(input, BlockReader::DefaultBlockCharacters, file, stream, beg, end);
+
+	KillMatrixWriter writer; writer.open(output, testnum, bias);
+	KillVectorProducer producer(testnum, bias);
+	KillVector vec(testnum); unsigned int rows = 0;
+	while (more) {
+		const char * cursor = beg;
+		while (cursor < end) {
+			const char * eol = (const char *)memchr(cursor, '\n', end - cursor);
+			if (eol == nullptr) eol = end;
+			bool valid = producer.produce(cursor, eol, vec);
+			cursor = eol + 1;
+			if (valid) { writer.write(vec); rows++; }
+		}
+		more = (stream != nullptr) && stream->next(beg, end);
+	}
+	writer.close();
+
+	if (file != nullptr) delete file;
+	if (stream != nullptr) delete stream;
+	return rows;
+}
+/* open input text (regular files are mapped, others like "-" for standard input are streamed in blocks of the given 
+characters), and get its first block in [beg, end) */
+bool openInput(const std::string & input, size_t block, MappedFile *& file, BlockReader *& stream, const char *& beg, const char *& end) {
+	if (MappedFile::can_map(input)) {
+		file = new MappedFile(input);
+		beg = file->begin(); end = file->end();
+		return true;
+	}
+	else {
+		stream = new BlockReader(input, block);
+		return stream->next(beg, end);
+	}
+}
+/* estimate the average density of kill-vectors from the first rows of kill-matrix */
+double densityOfMatrix(KillMatrixReader & matrix, int rows) {
+	KillVector vec(matrix.get_test_number());
+	double kills = 0; int vectors = 0;
+	while (vectors < rows && matrix.next(vec)) {
+		kills += vec.get_quantity(); vectors++;
+	}
+	matrix.reset();
+
+	if (vectors == 0 || matrix.get_test_number() == 0) return 1.0;
+	else return kills / vectors / matrix.get_test_number();
+}
+/* estimate the average density of kill-vectors from the first lines of text in [beg, end) */
+double densityOfInput(BitSeq::size_t bias, int testnum, const char * beg, const char * end, int lines) {
+	KillVectorProducer producer(testnum, bias);
+	KillVector vec(testnum);
+
+	double kills = 0; int vectors = 0;
+	const char * cursor = beg, * tail = end;
+	while (cursor < tail && vectors < lines) {
+		const char * eol = (const char *)memchr(cursor, '\n', tail - cursor);
+		if (eol == nullptr) eol = tail;
+		bool valid = producer.produce(cursor, eol, vec);
+		cursor = eol + 1;
+		if (!valid) continue;
+
+		kills += vec.get_quantity(); vectors++;
+	}
+
+	if (vectors == 0 || testnum <= 0) return 1.0;
+	else return kills / vectors / testnum;
+}
 void summaryOfDMSG(unsigned int killed, const DMSGVexIndex & index, 
 	const DMSGHierarchy & hierarchy, const DMSGraph & graph, std::ostream & out) {
 	
@@ -101,26 +322,64 @@ void summaryOfDMSG(unsigned int killed, const DMSGVexIndex & index,
 	out << "Number-Cluster  \t" << graph.number_of_vertices() << "\n";
 	out << "Length-Hierarchy\t" << hierarchy.number_of_levels() << "\n";
 
-	long id = 0, vnum = graph.number_of_vertices(); unsigned int edges = 0;
-	while (id < vnum) {
-		const DMSGVertex & vertex = graph.get_vertex(id++);
-		edges += vertex.out_degree();
+	out << "Direct-Subsume \t" << graph.number_of_edges() << "\n";
+}
+
+/* get the strategy of DMSGraphBuilder by its name in command line (-1 for unknown) */
+char strategyOf(const std::string & name) {
+	static const char * names[] = { "downtop", "topdown", "random", "inverted", "reduction", "auto" };
+	for (char k = DMSGraphBuilder::DownTop; k <= DMSGraphBuilder::Auto; k++)
+		if (name == names[(int)k]) return k;
+	return -1;
+}
+/* parse "--name=value" options from command line, and return the other arguments */
+std::vector<std::string> parseOptions(int argc, char * argv[], DMSGenOptions & options) {
+	std::vector<std::string> args;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg.compare(0, 2, "--") != 0) { args.push_back(arg); continue; }
+
+		size_t eq = arg.find('=');
+		std::string name = arg.substr(2, eq == std::string::npos ? std::string::npos : eq - 2);
+		std::string value = (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+		if (name == "dedup" && (value == "hash" || value == "trie"))
+			options.dedup = value;
+		else if (name == "threads" && !value.empty() && std::stoi(value) > 0)
+			options.threads = std::stoi(value);
+		else if (name == "schedule" && (value == "level" || value == "steal"))
+			options.schedule = value;
+		else if (name == "strategy" && strategyOf(value) >= 0)
+			options.strategy = strategyOf(value);
+		else if (name == "mode" && (value == "full" || value == "dominators"))
+			options.mode = value;
+		else if (name == "convert" && !value.empty())
+			options.convert = value;
+		else if (name == "update" && !value.empty())
+			options.update = value;
+		else throw "Invalid option: ", arg;
 	}
-	out << "Direct-Subsume \t" << edges << "\n";
+	return args;
 }
 
 int main(int argc, char * argv[]) {
 	BitSeq::size_t bias = 0; int testnum = 0;
-	std::string input, output;
-	if (argc < 4) throw "Invalid arguments: ", argc;
+	std::string input, output; DMSGenOptions options;
+	std::vector<std::string> args = parseOptions(argc, argv, options);
+	if (args.size() < 3) throw "Invalid arguments: ", argc;
 
-	bias = std::stoi(argv[1]);
-	testnum = std::stoi(argv[2]);
-	input = argv[3];
-	if (argc == 4) output = input + "_graph.dat";
-	else output = argv[4];
+	bias = std::stoi(args[0]);
+	testnum = std::stoi(args[1]);
+	input = args[2];
+	if (args.size() == 3 && input == "-" && options.convert.empty()) throw "Output file is required for standard input: ", argc;
+	else if (args.size() == 3) output = input + "_graph.dat";
+	else output = args[3];
 
-	generateDMSG(bias, testnum, input, output);
+	if (!options.convert.empty()) {
+		unsigned int rows = convertToMatrix(bias, testnum, input, options.convert);
+		std::cout << "Convert " << rows << " kill-vectors to " << options.convert << "\n";
+	}
+	else if (!options.update.empty()) updateDMSG(bias, testnum, input, output, options);
+	else generateDMSG(bias, testnum, input, output, options);
 
 	return 0;
 }
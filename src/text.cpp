@@ -1,5 +1,25 @@
 #include "text.h"
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <iterator>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define TEXT_MMAP
+#define text_open ::open
+#define text_read ::read
+#define text_close ::close
+#else
+#include <io.h>
+#include <fcntl.h>
+#define text_open ::_open
+#define text_read ::_read
+#define text_close ::_close
+#endif
+#include <cerrno>
 
 /** class LineReader: implement **/
 LineReader::LineReader(const std::string & filename) : in(filename.c_str(), std::ios::in) {
@@ -26,12 +46,7 @@ std::string LineReader::next() {
 	return ret;
 }
 void LineReader::roll() {
-	*line = "";
-	if (!in.eof()) {
-		in.getline(buff, MaximumLineCharacters);
-		*line = buff;
-	}
-	else {
+	if (!std::getline(in, *line)) {
 		delete line; line = nullptr;
 	}
 }
@@ -79,4 +94,147 @@ int TextBuild::lineOfIndex(int index) const {
 
 		return -1;
 	}
-}
\ No newline at end of file
+}
+/** class MappedFile: implement **/
+MappedFile::MappedFile(const std::string & filename) : data(nullptr), length(0), mapped(false), buffer() {
+#ifdef TEXT_MMAP
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		std::cerr << "Invalid filename: \"" << filename << "\"" << std::endl;
+		exit(1);
+	}
+	struct stat st;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		void * addr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr != MAP_FAILED) {
+			madvise(addr, (size_t)st.st_size, MADV_SEQUENTIAL);
+			data = (const char *)addr; length = (size_t)st.st_size; mapped = true;
+		}
+	}
+	::close(fd);
+	if (mapped) return;
+#endif
+	std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+	if (!in) {
+		std::cerr << "Invalid filename: \"" << filename << "\"" << std::endl;
+		exit(1);
+	}
+	buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	data = buffer.data(); length = buffer.size();
+}
+bool MappedFile::can_map(const std::string & filename) {
+	if (filename == "-") return false;
+#ifdef TEXT_MMAP
+	struct stat st;
+	if (::stat(filename.c_str(), &st) == 0) return S_ISREG(st.st_mode);
+#endif
+	return true;
+}
+MappedFile::~MappedFile() {
+#ifdef TEXT_MMAP
+	if (mapped) munmap((void *)data, length);
+#endif
+	data = nullptr; length = 0;
+}
+const char * MappedFile::line_end(const char * cursor) const {
+	const char * tail = end();
+	const char * eol = (const char *)memchr(cursor, '\n', tail - cursor);
+	return eol == nullptr ? tail : eol;
+}
+
+/** class BlockReader: implement **/
+BlockReader::BlockReader(int _fd, bool _owned, size_t block) : fd(_fd), owned(_owned), 
+	held(-1), expect(0), finished(false), error(0), stopped(false) {
+	if (fd < 0) {
+		std::cerr << "Invalid file descriptor: " << fd << std::endl;
+		exit(1);
+	}
+	this->start(block);
+}
+BlockReader::BlockReader(const std::string & filename, size_t block) : fd(0), owned(false),
+	held(-1), expect(0), finished(false), error(0), stopped(false) {
+	if (filename != "-") {
+		fd = text_open(filename.c_str(), O_RDONLY); owned = true;
+		if (fd < 0) {
+			std::cerr << "Invalid filename: \"" << filename << "\"" << std::endl;
+			exit(1);
+		}
+	}
+	this->start(block);
+}
+void BlockReader::start(size_t block) {
+	if (block == 0) block = DefaultBlockCharacters;
+	lengths[0] = lengths[1] = 0; ready[0] = ready[1] = false;
+	reader = std::thread(&BlockReader::run, this, block);
+}
+BlockReader::~BlockReader() {
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		stopped = true;
+	}
+	signal.notify_all();
+	reader.join();
+	if (owned) text_close(fd);
+}
+void BlockReader::run(size_t block) {
+	std::string carry; int k = 0;
+	while (true) {
+		/* wait for the block released by consumer */
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			while (!stopped && (ready[k] || held == k)) signal.wait(guard);
+			if (stopped) return;
+		}
+
+		/* the partial line of the last block comes first, then read until the block is full */
+		std::string & buff = blocks[k];
+		if (buff.size() < block || buff.size() < carry.size() * 2) 
+			buff.resize(block > carry.size() * 2 ? block : carry.size() * 2);
+		size_t length = carry.size(), scanned = 0; bool eof = false; int failure = 0;
+		memcpy(&buff[0], carry.data(), carry.size()); carry.clear();
+		while (true) {
+			while (length < buff.size()) {
+				long n = text_read(fd, &buff[length], (unsigned int)(buff.size() - length));
+				if (n < 0 && errno == EINTR) continue;
+				if (n < 0) failure = errno;
+				if (n <= 0) { eof = true; break; }
+				length += n;
+			}
+			/* a block must hold at least one whole line */
+			if (eof || memchr(&buff[scanned], '\n', length - scanned) != nullptr) break;
+			scanned = length; buff.resize(buff.size() * 2);
+		}
+
+		/* cut the block at its last line boundary */
+		size_t cut = length;
+		if (!eof) {
+			while (buff[cut - 1] != '\n') cut--;
+			carry.assign(&buff[cut], length - cut);
+		}
+
+		/* publish the block to consumer */
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			lengths[k] = cut; ready[k] = true;
+			if (eof) { finished = true; error = failure; }
+		}
+		signal.notify_all();
+		if (eof) return;
+		k = 1 - k;
+	}
+}
+bool BlockReader::next(const char *& beg, const char *& end) {
+	std::unique_lock<std::mutex> guard(lock);
+	/* release the block processed by consumer */
+	if (held >= 0) { held = -1; signal.notify_all(); }
+
+	while (!ready[expect] && !finished) signal.wait(guard);
+	if (!ready[expect]) {
+		if (error != 0) throw "Invalid read: ", error;
+		return false;
+	}
+
+	held = expect; ready[held] = false; expect = 1 - expect;
+	beg = blocks[held].data(); end = beg + lengths[held];
+	return true;
+}
@@ -5,6 +5,8 @@
 * 	-Cls:
 * 		[1] class LineReader;
 * 		[2] class TextBuild;
+* 		[3] class MappedFile;
+* 		[4] class BlockReader;
 * 	-Dat: March 10th, 2017
 * 	-Art: Lin Huan
 * **/
@@ -12,18 +14,20 @@
 #include <string>
 #include <vector>
 #include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 class LineReader;
 class TextBuild;
+class MappedFile;
+class BlockReader;
 
 /*
 * Reader to retrieve text from file line by line
 * */
 class LineReader {
 public:
-	/* maximum number of characters */
-	static const int MaximumLineCharacters = 24 * 1024;
-
 	/* constructor */
 	LineReader(const std::string &);
 	/* deconstructor */
@@ -37,10 +41,8 @@ public:
 private:
 	/* input stream for file */
 	std::ifstream in;
-	/* pointer to the next line */
+	/* pointer to the next line (of any length) */
 	std::string * line;
-	/* buffer to cache characters from file */
-	char buff[MaximumLineCharacters];
 
 	/* update pointer to the next line */
 	void roll();
@@ -75,3 +77,81 @@ private:
 	std::vector<int> lines;
 
 };
+
+/*
+* Whole file mapped into memory (read-only), so that lines are scanned in place.
+* The file is read into a buffer when it cannot be mapped (e.g. empty files or pipes).
+* */
+class MappedFile {
+public:
+	/* map the file of specified name */
+	MappedFile(const std::string &);
+	/* whether the file is regular (not a pipe, device or the standard input "-") to be mapped */
+	static bool can_map(const std::string &);
+	/* unmap the file */
+	~MappedFile();
+
+	/* the first character of file */
+	const char * begin() const { return data; }
+	/* the position next to the last character */
+	const char * end() const { return data + length; }
+	/* number of characters in file */
+	size_t size() const { return length; }
+
+	/* the end of line starting from cursor (its '\n' or the end of file) */
+	const char * line_end(const char * cursor) const;
+
+private:
+	/* characters in file */
+	const char * data;
+	/* number of characters */
+	size_t length;
+	/* whether data is mapped (or buffered) */
+	bool mapped;
+	/* buffer used when the file cannot be mapped */
+	std::string buffer;
+};
+
+/*
+* Reader of text from a file descriptor (standard input, pipe, ...) in blocks of
+* whole lines. A thread reads the next block while the current one is processed,
+* so memory is bounded by two blocks (a block grows only to hold a longer line).
+* */
+class BlockReader {
+public:
+	/* default number of characters in a block */
+	static const size_t DefaultBlockCharacters = 4 << 20;
+
+	/* start reading from the file descriptor (closed if owned) */
+	BlockReader(int fd, bool owned, size_t block = DefaultBlockCharacters);
+	/* start reading from the named file ("-" for the standard input) */
+	BlockReader(const std::string &, size_t block = DefaultBlockCharacters);
+	/* stop reading and release the blocks */
+	~BlockReader();
+
+	/* get the next block of whole lines in [beg, end), false at the end of input */
+	bool next(const char *& beg, const char *& end);
+
+private:
+	/* file descriptor and whether to close it */
+	int fd; bool owned;
+	/* two blocks, their lengths and whether they are ready for the consumer */
+	std::string blocks[2];
+	size_t lengths[2];
+	bool ready[2];
+	/* the block held by the consumer (-1 for none) and the next one to consume */
+	int held, expect;
+	/* whether the input ends (after the ready blocks), or it is failed (errno) */
+	bool finished; int error;
+	/* whether the reader is asked to stop */
+	bool stopped;
+	/* synchronization between reader thread and consumer */
+	std::mutex lock;
+	std::condition_variable signal;
+	std::thread reader;
+
+	/* start the reader thread */
+	void start(size_t block);
+	/* fill blocks until the end of input (run by reader thread) */
+	void run(size_t block);
+};